@@ -0,0 +1,188 @@
+#include "Generators.hpp"
+
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+static const float PI = 3.14159265358979f;
+
+GeneratedMesh generateSphere(size_t targetFaces)
+{
+    GeneratedMesh mesh;
+
+    // icosahedron
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    mesh.vertices = {
+        { -1,  t,  0 }, {  1,  t,  0 }, { -1, -t,  0 }, {  1, -t,  0 },
+        {  0, -1,  t }, {  0,  1,  t }, {  0, -1, -t }, {  0,  1, -t },
+        {  t,  0, -1 }, {  t,  0,  1 }, { -t,  0, -1 }, { -t,  0,  1 }
+    };
+    mesh.indices = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+    };
+
+    int level = 0;
+    while (mesh.getFaceCount() < targetFaces)
+    {
+        // split every edge once (midpoints are shared through the edge map)
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        auto midpoint = [&mesh, &midpoints](uint32_t a, uint32_t b)
+        {
+            uint64_t key = ((uint64_t)std::min(a, b) << 32) | std::max(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end()) return it->second;
+
+            uint32_t index = (uint32_t)mesh.vertices.size();
+            mesh.vertices.push_back((mesh.vertices[a] + mesh.vertices[b]) * 0.5f);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<uint32_t> indices;
+        indices.reserve(mesh.indices.size() * 4);
+        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        {
+            uint32_t v0 = mesh.indices[i], v1 = mesh.indices[i + 1], v2 = mesh.indices[i + 2];
+            uint32_t a = midpoint(v0, v1), b = midpoint(v1, v2), c = midpoint(v2, v0);
+
+            uint32_t faces[] = { v0, a, c,   v1, b, a,   v2, c, b,   a, b, c };
+            indices.insert(indices.end(), faces, faces + 12);
+        }
+        mesh.indices = std::move(indices);
+        level++;
+    }
+
+    for (auto& v : mesh.vertices)
+        v = glm::normalize(v);
+
+    mesh.name = "sphere" + std::to_string(level);
+    return mesh;
+}
+
+GeneratedMesh generateHeightField(size_t targetFaces, uint32_t seed)
+{
+    GeneratedMesh mesh;
+
+    // a grid of n x n vertices has 2 * (n - 1)^2 faces
+    size_t n = (size_t)std::sqrt(targetFaces / 2.0) + 1;
+    n = std::max<size_t>(n, 2);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    std::uniform_real_distribution<float> phase(0.0f, 2.0f * PI);
+
+    // a few octaves of randomly shifted waves
+    const int octaves = 5;
+    float phases[octaves][2];
+    for (auto& p : phases)
+    {
+        p[0] = phase(rng);
+        p[1] = phase(rng);
+    }
+
+    float step = 2.0f / (float)(n - 1);
+    mesh.vertices.reserve(n * n);
+    for (size_t y = 0; y < n; ++y)
+    {
+        for (size_t x = 0; x < n; ++x)
+        {
+            float px = -1.0f + x * step + jitter(rng) * step * 0.25f;
+            float pz = -1.0f + y * step + jitter(rng) * step * 0.25f;
+
+            float height = 0.0f;
+            float amplitude = 0.25f;
+            float frequency = 2.0f;
+            for (auto& p : phases)
+            {
+                height += amplitude * std::sin(frequency * px + p[0]) * std::cos(frequency * pz + p[1]);
+                amplitude *= 0.5f;
+                frequency *= 2.1f;
+            }
+            height += jitter(rng) * step * 0.1f;
+
+            mesh.vertices.push_back({ px, height, pz });
+        }
+    }
+
+    mesh.indices.reserve(6 * (n - 1) * (n - 1));
+    for (size_t y = 0; y + 1 < n; ++y)
+    {
+        for (size_t x = 0; x + 1 < n; ++x)
+        {
+            uint32_t v0 = (uint32_t)(y * n + x);
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + (uint32_t)n;
+            uint32_t v3 = v2 + 1;
+
+            uint32_t faces[] = { v0, v2, v1,   v1, v2, v3 };
+            mesh.indices.insert(mesh.indices.end(), faces, faces + 6);
+        }
+    }
+
+    mesh.name = "heightfield" + std::to_string(n);
+    return mesh;
+}
+
+GeneratedMesh generateTorusKnot(size_t targetFaces, int p, int q)
+{
+    GeneratedMesh mesh;
+
+    // segments * sides * 2 faces with four times more segments than sides
+    size_t sides = std::max<size_t>(3, (size_t)std::sqrt(targetFaces / 8.0));
+    size_t segments = 4 * sides;
+
+    auto curve = [p, q](float t)
+    {
+        float r = 2.0f + std::cos(q * t);
+        return glm::vec3(r * std::cos(p * t), r * std::sin(p * t), std::sin(q * t)) * 0.4f;
+    };
+
+    mesh.vertices.reserve(segments * sides);
+    for (size_t i = 0; i < segments; ++i)
+    {
+        float t = 2.0f * PI * i / segments;
+        glm::vec3 center = curve(t);
+        glm::vec3 tangent = glm::normalize(curve(t + 0.001f) - curve(t - 0.001f));
+
+        // frame around the tangent
+        glm::vec3 normal = glm::normalize(glm::cross(tangent, glm::vec3(0.0f, 0.0f, 1.0f)));
+        glm::vec3 binormal = glm::cross(tangent, normal);
+
+        for (size_t j = 0; j < sides; ++j)
+        {
+            float a = 2.0f * PI * j / sides;
+            mesh.vertices.push_back(center + (normal * std::cos(a) + binormal * std::sin(a)) * 0.15f);
+        }
+    }
+
+    mesh.indices.reserve(6 * segments * sides);
+    for (size_t i = 0; i < segments; ++i)
+    {
+        for (size_t j = 0; j < sides; ++j)
+        {
+            uint32_t v0 = (uint32_t)(i * sides + j);
+            uint32_t v1 = (uint32_t)(i * sides + (j + 1) % sides);
+            uint32_t v2 = (uint32_t)(((i + 1) % segments) * sides + j);
+            uint32_t v3 = (uint32_t)(((i + 1) % segments) * sides + (j + 1) % sides);
+
+            uint32_t faces[] = { v0, v2, v1,   v1, v2, v3 };
+            mesh.indices.insert(mesh.indices.end(), faces, faces + 6);
+        }
+    }
+
+    mesh.name = "torusknot" + std::to_string(segments) + "x" + std::to_string(sides);
+    return mesh;
+}
+
+bool generateMesh(const std::string& family, size_t targetFaces, uint32_t seed, GeneratedMesh& mesh)
+{
+    if (family == "sphere")      mesh = generateSphere(targetFaces);
+    else if (family == "heightfield") mesh = generateHeightField(targetFaces, seed);
+    else if (family == "torusknot")   mesh = generateTorusKnot(targetFaces);
+    else return false;
+
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// procedurally generated test meshes, all generators are deterministic for a given seed
+struct GeneratedMesh
+{
+    std::string name;
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t getFaceCount() const { return indices.size() / 3; }
+};
+
+// icosahedron subdivided until it has at least targetFaces faces (20 * 4^n faces)
+GeneratedMesh generateSphere(size_t targetFaces);
+
+// square grid with fractal noise heights and random jitter (about targetFaces faces)
+GeneratedMesh generateHeightField(size_t targetFaces, uint32_t seed);
+
+// tube around a (p, q) torus knot (about targetFaces faces)
+GeneratedMesh generateTorusKnot(size_t targetFaces, int p = 2, int q = 3);
+
+// generate a mesh of the named family ("sphere", "heightfield" or "torusknot")
+bool generateMesh(const std::string& family, size_t targetFaces, uint32_t seed, GeneratedMesh& mesh);
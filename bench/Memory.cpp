@@ -0,0 +1,85 @@
+#include "Memory.hpp"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <cstdio>
+    #include <cstdlib>
+    #include <cstring>
+    #include <sys/resource.h>
+    #ifdef __GLIBC__
+        #include <malloc.h>
+    #endif
+#endif
+
+#ifdef _WIN32
+
+bool resetPeakMemory()
+{
+    // the peak working set can not be reset, trimming keeps the following peaks meaningful
+    EmptyWorkingSet(GetCurrentProcess());
+    return false;
+}
+
+size_t getPeakMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return counters.PeakWorkingSetSize;
+}
+
+#else
+
+bool resetPeakMemory()
+{
+#ifdef __GLIBC__
+    // hand freed memory of earlier runs back, otherwise it counts towards the next peak
+    malloc_trim(0);
+#endif
+
+    // writing 5 to clear_refs resets VmHWM (linux only)
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (!file) return false;
+
+    bool success = fputs("5", file) >= 0;
+    return (fclose(file) == 0) && success;
+}
+
+size_t getPeakMemory()
+{
+    // prefer VmHWM, it is reset by resetPeakMemory
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file)
+    {
+        char line[256];
+        size_t peak = 0;
+        while (fgets(line, sizeof(line), file))
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                peak = (size_t)strtoull(line + 6, nullptr, 10) * 1024;
+                break;
+            }
+        }
+        fclose(file);
+
+        if (peak > 0) return peak;
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// reset the peak resident set size of the process (returns false if the platform can not reset it)
+bool resetPeakMemory();
+
+// peak resident set size of the process in bytes
+size_t getPeakMemory();
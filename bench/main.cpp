@@ -0,0 +1,368 @@
+#include "Generators.hpp"
+#include "Memory.hpp"
+
+#include "MeshCache.hpp"
+#include "MeshData.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjWriter.hpp"
+#include "QuadricKernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Options
+{
+    std::vector<size_t> sizes = { 10000, 100000, 1000000 };
+    std::vector<std::string> families = { "sphere", "heightfield", "torusknot" };
+    std::string resDir = "res";
+    std::string output = "benchmark.csv";
+
+    float ratio = 0.1f;
+    size_t threads = 0;
+    uint32_t seed = 1;
+    std::string kernel;     // quadric kernel (empty picks the best one)
+    bool json = false;
+};
+
+struct BenchResult
+{
+    std::string family;
+    std::string name;
+
+    size_t faces = 0;
+    size_t vertices = 0;
+    size_t targetFaces = 0;
+    size_t resultFaces = 0;
+    size_t collapses = 0;
+
+    // wall times in seconds
+    double loadObj = 0.0;
+    double loadCache = 0.0;
+    double setup = 0.0;
+    double run = 0.0;
+
+    size_t peakMemory = 0;
+
+    // phase times and counters (zero without MS_INSTRUMENT)
+    SimplifierStats stats;
+};
+
+static void printUsage()
+{
+    printf("usage: benchmark [options]\n");
+    printf("\n");
+    printf("options:\n");
+    printf("  --sizes <n,...>       face counts of the generated meshes (default: 10000,100000,1000000)\n");
+    printf("  --families <f,...>    generated mesh families: sphere, heightfield, torusknot (default: all)\n");
+    printf("  --res <dir>           directory with .obj models to benchmark, \"\" to skip (default: res)\n");
+    printf("  --ratio <r>           target face count relative to the input (default: 0.1)\n");
+    printf("  --threads <n>         threads used by setup (default: all cores)\n");
+    printf("  --seed <n>            seed of the noisy meshes (default: 1)\n");
+    printf("  --kernel <name>       quadric kernel: scalar, sse, avx2 (default: best supported)\n");
+    printf("  -o, --output <file>   result file, .json writes json otherwise csv (default: benchmark.csv)\n");
+}
+
+template<typename Func>
+static void splitList(const char* list, Func func)
+{
+    std::string item;
+    for (const char* c = list; ; ++c)
+    {
+        if (*c == ',' || *c == '\0')
+        {
+            if (!item.empty()) func(item);
+            item.clear();
+            if (*c == '\0') break;
+        }
+        else
+        {
+            item += *c;
+        }
+    }
+}
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--sizes") == 0 && hasValue)
+        {
+            options.sizes.clear();
+            splitList(argv[++i], [&options](const std::string& s) { options.sizes.push_back((size_t)atof(s.c_str())); });
+        }
+        else if (strcmp(arg, "--families") == 0 && hasValue)
+        {
+            options.families.clear();
+            splitList(argv[++i], [&options](const std::string& s) { options.families.push_back(s); });
+        }
+        else if (strcmp(arg, "--res") == 0 && hasValue)        options.resDir = argv[++i];
+        else if (strcmp(arg, "--ratio") == 0 && hasValue)      options.ratio = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--threads") == 0 && hasValue)    options.threads = (size_t)atoll(argv[++i]);
+        else if (strcmp(arg, "--seed") == 0 && hasValue)       options.seed = (uint32_t)atoll(argv[++i]);
+        else if (strcmp(arg, "--kernel") == 0 && hasValue)     options.kernel = argv[++i];
+        else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) && hasValue) options.output = argv[++i];
+        else
+        {
+            printf("Unknown option \"%s\".\n", arg);
+            return false;
+        }
+    }
+
+    if (!options.kernel.empty())
+    {
+        bool found = false;
+        for (int kernel = 0; kernel < (int)QuadricKernel::Count && !found; ++kernel)
+        {
+            if (options.kernel == getKernelName((QuadricKernel)kernel))
+            {
+                found = true;
+                if (!setQuadricKernel((QuadricKernel)kernel))
+                {
+                    printf("The kernel \"%s\" is not supported by this cpu.\n", options.kernel.c_str());
+                    return false;
+                }
+            }
+        }
+
+        if (!found)
+        {
+            printf("Unknown kernel \"%s\".\n", options.kernel.c_str());
+            return false;
+        }
+    }
+
+    options.json = fs::path(options.output).extension() == ".json";
+    return true;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// time loading the .obj file, loading its binary cache, setup and run
+static BenchResult benchmark(const std::string& family, const std::string& name, const fs::path& objFile, const fs::path& tempDir, const Options& options)
+{
+    BenchResult result;
+    result.family = family;
+    result.name = name;
+
+    resetPeakMemory();
+
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    {
+        auto start = std::chrono::steady_clock::now();
+        MeshData data(objFile.string(), false);
+        result.loadObj = secondsSince(start);
+
+        fs::path cacheFile = tempDir / (name + MESH_CACHE_EXTENSION);
+        if (writeMeshCache(cacheFile.string(), data.getVertices(), data.getIndices()))
+        {
+            start = std::chrono::steady_clock::now();
+            MeshData cache(cacheFile.string());
+            result.loadCache = secondsSince(start);
+        }
+
+        data.release(vertices, indices);
+    }
+
+    result.faces = indices.size() / 3;
+    result.vertices = vertices.size();
+    result.targetFaces = (size_t)(result.faces * options.ratio);
+
+    MeshSimplifier simplifier;
+    simplifier.setThreadCount(options.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    simplifier.setup(std::move(vertices), std::move(indices));
+    result.setup = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    simplifier.run(result.targetFaces);
+    result.run = secondsSince(start);
+
+    result.resultFaces = simplifier.getFaceCount();
+    result.collapses = simplifier.getCollapseCount();
+    result.stats = simplifier.getStats();
+    result.peakMemory = getPeakMemory();
+
+    return result;
+}
+
+// least squares fit of log(time) = a + b * log(faces), returns b
+static double scalingExponent(const std::vector<BenchResult>& results, const std::string& family, double BenchResult::* time, double BenchResult::* time2 = nullptr)
+{
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    int n = 0;
+    for (auto& r : results)
+    {
+        double t = r.*time + (time2 ? r.*time2 : 0.0);
+        if (r.family != family || r.faces == 0 || t <= 0.0) continue;
+
+        double x = std::log((double)r.faces);
+        double y = std::log(t);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        n++;
+    }
+
+    double d = n * sxx - sx * sx;
+    if (n < 2 || d == 0.0) return NAN;
+
+    return (n * sxy - sx * sy) / d;
+}
+
+static double collapsesPerSecond(const BenchResult& r)
+{
+    return r.run > 0.0 ? r.collapses / r.run : 0.0;
+}
+
+static bool writeResults(const std::vector<BenchResult>& results, const std::vector<std::string>& families, const Options& options)
+{
+    FILE* file = fopen(options.output.c_str(), "w");
+    if (!file)
+    {
+        printf("Failed to open \"%s\" for writing.\n", options.output.c_str());
+        return false;
+    }
+
+    if (options.json)
+    {
+        fprintf(file, "{\n  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& r = results[i];
+            fprintf(file, "    { \"family\": \"%s\", \"mesh\": \"%s\", \"faces\": %zd, \"vertices\": %zd, \"target_faces\": %zd, \"result_faces\": %zd, "
+                "\"load_obj_ms\": %.3f, \"load_cache_ms\": %.3f, \"setup_ms\": %.3f, \"run_ms\": %.3f, \"collapses\": %zd, \"collapses_per_sec\": %.0f, \"peak_rss_mb\": %.1f, "
+                "\"quadrics_ms\": %.3f, \"pairs_ms\": %.3f, \"heap_ms\": %.3f, \"remove_vertex_ms\": %.3f, \"pair_cost_ms\": %.3f, \"pairs_recomputed\": %zd }%s\n",
+                r.family.c_str(), r.name.c_str(), r.faces, r.vertices, r.targetFaces, r.resultFaces,
+                r.loadObj * 1e3, r.loadCache * 1e3, r.setup * 1e3, r.run * 1e3, r.collapses, collapsesPerSecond(r), r.peakMemory / 1048576.0,
+                r.stats.getTime(StatsPhase::Errors) * 1e3, r.stats.getTime(StatsPhase::Pairs) * 1e3, r.stats.getTime(StatsPhase::Heap) * 1e3,
+                r.stats.getTime(StatsPhase::RemoveVertex) * 1e3, r.stats.getTime(StatsPhase::PairCost) * 1e3, r.stats.pairsRecomputed,
+                i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ],\n  \"scaling\": [\n");
+        for (size_t i = 0; i < families.size(); ++i)
+        {
+            auto& f = families[i];
+            fprintf(file, "    { \"family\": \"%s\", \"load_obj\": %.3f, \"setup\": %.3f, \"run\": %.3f, \"total\": %.3f }%s\n", f.c_str(),
+                scalingExponent(results, f, &BenchResult::loadObj), scalingExponent(results, f, &BenchResult::setup),
+                scalingExponent(results, f, &BenchResult::run), scalingExponent(results, f, &BenchResult::setup, &BenchResult::run),
+                i + 1 < families.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+    }
+    else
+    {
+        fprintf(file, "family,mesh,faces,vertices,target_faces,result_faces,load_obj_ms,load_cache_ms,setup_ms,run_ms,collapses,collapses_per_sec,peak_rss_mb,"
+            "quadrics_ms,pairs_ms,heap_ms,remove_vertex_ms,pair_cost_ms,pairs_recomputed\n");
+        for (auto& r : results)
+        {
+            fprintf(file, "%s,%s,%zd,%zd,%zd,%zd,%.3f,%.3f,%.3f,%.3f,%zd,%.0f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f,%zd\n",
+                r.family.c_str(), r.name.c_str(), r.faces, r.vertices, r.targetFaces, r.resultFaces,
+                r.loadObj * 1e3, r.loadCache * 1e3, r.setup * 1e3, r.run * 1e3, r.collapses, collapsesPerSecond(r), r.peakMemory / 1048576.0,
+                r.stats.getTime(StatsPhase::Errors) * 1e3, r.stats.getTime(StatsPhase::Pairs) * 1e3, r.stats.getTime(StatsPhase::Heap) * 1e3,
+                r.stats.getTime(StatsPhase::RemoveVertex) * 1e3, r.stats.getTime(StatsPhase::PairCost) * 1e3, r.stats.pairsRecomputed);
+        }
+
+        // scaling exponents as a second table
+        fprintf(file, "\nfamily,load_obj_exponent,setup_exponent,run_exponent,total_exponent\n");
+        for (auto& f : families)
+        {
+            fprintf(file, "%s,%.3f,%.3f,%.3f,%.3f\n", f.c_str(),
+                scalingExponent(results, f, &BenchResult::loadObj), scalingExponent(results, f, &BenchResult::setup),
+                scalingExponent(results, f, &BenchResult::run), scalingExponent(results, f, &BenchResult::setup, &BenchResult::run));
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    printf("Quadric kernel: %s\n", getKernelName(getQuadricKernel()));
+
+    std::error_code error;
+    fs::path tempDir = fs::temp_directory_path(error) / "meshsimplifier-bench";
+    fs::create_directories(tempDir, error);
+
+    std::vector<BenchResult> results;
+
+    // models shipped with the repository
+    if (!options.resDir.empty())
+    {
+        std::vector<fs::path> models;
+        for (auto& entry : fs::directory_iterator(options.resDir, error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".obj")
+                models.push_back(entry.path());
+        }
+        std::sort(models.begin(), models.end());
+
+        for (auto& model : models)
+            results.push_back(benchmark("res", model.stem().string(), model, tempDir, options));
+    }
+
+    // generated meshes, written to .obj files first to include the loader
+    for (auto& family : options.families)
+    {
+        for (size_t size : options.sizes)
+        {
+            GeneratedMesh mesh;
+            if (!generateMesh(family, size, options.seed, mesh))
+            {
+                printf("Unknown mesh family \"%s\".\n", family.c_str());
+                break;
+            }
+
+            fs::path objFile = tempDir / (mesh.name + ".obj");
+            if (!writeObj(objFile.string(), mesh.vertices, mesh.indices))
+                continue;
+
+            std::string name = mesh.name;
+            mesh = GeneratedMesh();
+
+            results.push_back(benchmark(family, name, objFile, tempDir, options));
+            fs::remove(objFile, error);
+        }
+    }
+
+    fs::remove_all(tempDir, error);
+
+    printf("\n%-12s %-22s %10s %10s %10s %10s %10s %12s %10s\n", "family", "mesh", "faces", "load ms", "setup ms", "run ms", "result", "collapses/s", "peak MB");
+    for (auto& r : results)
+    {
+        printf("%-12s %-22s %10zd %10.1f %10.1f %10.1f %10zd %12.0f %10.1f\n", r.family.c_str(), r.name.c_str(), r.faces,
+            r.loadObj * 1e3, r.setup * 1e3, r.run * 1e3, r.resultFaces, collapsesPerSecond(r), r.peakMemory / 1048576.0);
+    }
+
+    printf("\n%-12s %10s %10s %10s %10s\n", "scaling", "load", "setup", "run", "total");
+    for (auto& f : options.families)
+    {
+        printf("%-12s %10.3f %10.3f %10.3f %10.3f\n", f.c_str(),
+            scalingExponent(results, f, &BenchResult::loadObj), scalingExponent(results, f, &BenchResult::setup),
+            scalingExponent(results, f, &BenchResult::run), scalingExponent(results, f, &BenchResult::setup, &BenchResult::run));
+    }
+
+    return writeResults(results, options.families, options) ? 0 : 1;
+}
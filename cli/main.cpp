@@ -0,0 +1,527 @@
+#include "MeshData.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjWriter.hpp"
+#include "ObjectSimplifier.hpp"
+#include "Parallel.hpp"
+#include "StreamingSimplifier.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Options
+{
+    std::vector<fs::path> inputs;
+    fs::path output;
+
+    float ratio = 0.5f;     // target face count relative to the input
+    size_t faces = 0;       // absolute target face count (overrides ratio)
+    std::vector<float> lods;    // ratios of the levels of detail (replaces ratio/faces if set)
+
+    size_t jobs = 0;        // meshes processed in parallel (0 uses all hardware threads)
+    size_t threads = 0;     // threads per mesh (0 picks one per job)
+
+    size_t memory = 0;      // memory budget in MB per job, enables streaming (0 loads the whole mesh)
+    float weld = -1.0f;     // merge vertices closer than this after loading (negative disables welding)
+    float distance = 0.0f;  // also pair vertices closer than this that share no edge
+
+    bool useCache = true;
+    bool parallel = false;  // collapse batches of independent pairs concurrently
+    bool cluster = false;   // vertex clustering before the collapses
+    bool optimize = false;  // reorder the output for the vertex cache and vertex fetch
+    bool overdraw = false;  // also reorder the faces for less overdraw
+    bool binary = false;    // write binary mesh caches (.msb) instead of .obj files
+    bool objects = false;   // simplify the objects of the input separately and concurrently
+    FaceBudget budget = FaceBudget::Proportional;
+    QuadricPrecision precision = QuadricPrecision::Float;
+
+    std::string trace;      // chrome trace output (empty disables tracing)
+};
+
+static void printUsage()
+{
+    printf("usage: meshsimplify [options] <input>...\n");
+    printf("\n");
+    printf("inputs can be .obj/.msb files or directories (all .obj files in it are processed).\n");
+    printf("\n");
+    printf("options:\n");
+    printf("  -o, --output <path>   output file (single input, .msb writes a binary mesh cache) or directory\n");
+    printf("                        (default: <input>.simplified.obj next to the input)\n");
+    printf("  -b, --binary          write binary mesh caches (.msb) instead of .obj files\n");
+    printf("  -r, --ratio <r>       target face count relative to the input (default: 0.5)\n");
+    printf("  -f, --faces <n>       target face count (overrides --ratio)\n");
+    printf("  -l, --lods <r,...>    write one level of detail per ratio in a single pass\n");
+    printf("                        (<output>.lod<i>.obj, level 0 is the finest, not with -p or -c)\n");
+    printf("  -j, --jobs <n>        number of meshes simplified in parallel (default: all cores)\n");
+    printf("  -t, --threads <n>     threads used per mesh (default: cores / jobs)\n");
+    printf("  -p, --parallel        collapse independent pairs concurrently (slightly different result)\n");
+    printf("  -m, --memory <mb>     stream .obj inputs through chunks that fit the memory budget\n");
+    printf("                        (per job, for meshes larger than the memory)\n");
+    printf("  -w, --weld <eps>      merge vertices at most eps apart after loading (0 merges equal positions)\n");
+    printf("  -d, --distance <t>    also collapse vertices closer than t without an edge (merges parts)\n");
+    printf("  -c, --cluster         grid vertex clustering before the collapses (fast for huge inputs)\n");
+    printf("      --double          double precision quadrics (large coordinates, e.g. CAD data)\n");
+    printf("  -O, --optimize        reorder the output faces and vertices for rendering\n");
+    printf("      --overdraw        like --optimize, also sort the faces to reduce overdraw\n");
+    printf("      --objects         simplify every object (o/g) of the input on its own, concurrently\n");
+    printf("                        (vertices shared between objects are kept, not with -m or -l)\n");
+    printf("      --budget <mode>   split the faces between objects: faces (same ratio, default) or\n");
+    printf("                        error (same collapse cost, implies --objects)\n");
+    printf("      --no-cache        do not read or write binary mesh caches\n");
+    printf("      --trace <file>    write a chrome trace of the run (needs MS_INSTRUMENT)\n");
+    printf("  -h, --help            show this message\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+            return false;
+        }
+        else if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) && hasValue)
+        {
+            options.output = argv[++i];
+        }
+        else if ((strcmp(arg, "-r") == 0 || strcmp(arg, "--ratio") == 0) && hasValue)
+        {
+            options.ratio = (float)atof(argv[++i]);
+        }
+        else if ((strcmp(arg, "-f") == 0 || strcmp(arg, "--faces") == 0) && hasValue)
+        {
+            options.faces = (size_t)atoll(argv[++i]);
+        }
+        else if ((strcmp(arg, "-l") == 0 || strcmp(arg, "--lods") == 0) && hasValue)
+        {
+            for (char* ratio = strtok(argv[++i], ","); ratio; ratio = strtok(nullptr, ","))
+                options.lods.push_back((float)atof(ratio));
+        }
+        else if ((strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) && hasValue)
+        {
+            options.jobs = (size_t)atoll(argv[++i]);
+        }
+        else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) && hasValue)
+        {
+            options.threads = (size_t)atoll(argv[++i]);
+        }
+        else if (strcmp(arg, "--trace") == 0 && hasValue)
+        {
+            options.trace = argv[++i];
+        }
+        else if ((strcmp(arg, "-m") == 0 || strcmp(arg, "--memory") == 0) && hasValue)
+        {
+            options.memory = (size_t)atoll(argv[++i]);
+        }
+        else if ((strcmp(arg, "-w") == 0 || strcmp(arg, "--weld") == 0) && hasValue)
+        {
+            options.weld = (float)atof(argv[++i]);
+        }
+        else if ((strcmp(arg, "-d") == 0 || strcmp(arg, "--distance") == 0) && hasValue)
+        {
+            options.distance = (float)atof(argv[++i]);
+        }
+        else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--binary") == 0)
+        {
+            options.binary = true;
+        }
+        else if (strcmp(arg, "-p") == 0 || strcmp(arg, "--parallel") == 0)
+        {
+            options.parallel = true;
+        }
+        else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--cluster") == 0)
+        {
+            options.cluster = true;
+        }
+        else if (strcmp(arg, "--double") == 0)
+        {
+            options.precision = QuadricPrecision::Double;
+        }
+        else if (strcmp(arg, "-O") == 0 || strcmp(arg, "--optimize") == 0)
+        {
+            options.optimize = true;
+        }
+        else if (strcmp(arg, "--overdraw") == 0)
+        {
+            options.optimize = true;
+            options.overdraw = true;
+        }
+        else if (strcmp(arg, "--objects") == 0)
+        {
+            options.objects = true;
+        }
+        else if (strcmp(arg, "--budget") == 0 && hasValue)
+        {
+            const char* budget = argv[++i];
+            if (strcmp(budget, "faces") == 0)
+            {
+                options.budget = FaceBudget::Proportional;
+            }
+            else if (strcmp(budget, "error") == 0)
+            {
+                options.budget = FaceBudget::Error;
+                options.objects = true;
+            }
+            else
+            {
+                printf("Unknown budget \"%s\".\n", budget);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--no-cache") == 0)
+        {
+            options.useCache = false;
+        }
+        else if (arg[0] == '-')
+        {
+            printf("Unknown option \"%s\".\n", arg);
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.ratio < 0.0f || options.ratio > 1.0f)
+    {
+        printf("The ratio has to be between 0 and 1.\n");
+        return false;
+    }
+
+    for (float lod : options.lods)
+    {
+        if (lod < 0.0f || lod > 1.0f)
+        {
+            printf("The ratios of the levels of detail have to be between 0 and 1.\n");
+            return false;
+        }
+    }
+
+    // streaming and levels of detail work on the whole mesh, clusters can not be recorded for error budgets
+    if (options.objects && (options.memory > 0 || !options.lods.empty()))
+    {
+        printf("Objects can not be simplified separately with --memory or --lods.\n");
+        return false;
+    }
+
+    if (options.budget == FaceBudget::Error && options.cluster)
+    {
+        printf("Error budgets can not be combined with --cluster.\n");
+        return false;
+    }
+
+    // levels of detail are snapshots of one serial run
+    if (!options.lods.empty() && (options.parallel || options.cluster))
+    {
+        printf("Levels of detail can not be combined with --parallel or --cluster.\n");
+        return false;
+    }
+
+    return !options.inputs.empty();
+}
+
+struct Task
+{
+    fs::path input;
+    fs::path output;
+};
+
+// expand directories and pick the output path of every input
+static std::vector<Task> collectTasks(const Options& options)
+{
+    std::vector<fs::path> files;
+    for (auto& input : options.inputs)
+    {
+        std::error_code error;
+        if (!fs::is_directory(input, error))
+        {
+            files.push_back(input);
+            continue;
+        }
+
+        for (auto& entry : fs::directory_iterator(input, error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".obj")
+                files.push_back(entry.path());
+        }
+    }
+
+    // a single input can be written to a file, otherwise the output is a directory
+    bool outputIsFile = files.size() == 1 && options.output.has_extension() && !fs::is_directory(options.output);
+
+    std::string extension = options.binary ? MESH_CACHE_EXTENSION : ".obj";
+
+    std::vector<Task> tasks;
+    for (auto& file : files)
+    {
+        Task task;
+        task.input = file;
+
+        if (options.output.empty())
+            task.output = fs::path(file).replace_extension(".simplified" + extension);
+        else if (outputIsFile)
+            task.output = options.output;
+        else
+            task.output = options.output / fs::path(file).filename().replace_extension(extension);
+
+        tasks.push_back(task);
+    }
+
+    return tasks;
+}
+
+// write the levels of detail as <output>.lod<i>.obj (or .msb)
+template<typename Simplifier>
+static bool processLods(const Task& task, Simplifier& simplifier, const Options& options, size_t threads, std::chrono::steady_clock::time_point start)
+{
+    size_t inputFaces = simplifier.getFaceCount();
+    LodChain chain = simplifier.buildLodsByRatio(options.lods);
+
+    MS_TRACE_SCOPE("write");
+    for (size_t level = 0; level < chain.levels.size(); ++level)
+    {
+        fs::path output = fs::path(task.output).replace_extension(".lod" + std::to_string(level) + task.output.extension().string());
+        std::span<const uint32_t> levelIndices = chain.getIndices(level);
+
+        // the vertices are shared by all levels, only the faces are reordered
+        std::vector<uint32_t> optimizedIndices;
+        if (options.optimize)
+        {
+            optimizedIndices.assign(levelIndices.begin(), levelIndices.end());
+            if (options.overdraw)
+                optimizeOverdraw(optimizedIndices, chain.vertices);
+            else
+                optimizeVertexCache(optimizedIndices, chain.vertices.size());
+            levelIndices = optimizedIndices;
+        }
+
+        if (!writeMesh(output.string(), chain.vertices, levelIndices, {}, threads))
+            return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Simplified \"%s\" (%zd faces) into %zd levels of detail (%zd shared vertices) in %.3fs\n", task.input.string().c_str(),
+        inputFaces, chain.levels.size(), chain.vertices.size(), seconds);
+
+    return true;
+}
+
+// simplify every object on its own and write them as objects of one file
+static bool processObjects(const Task& task, const MeshData& data, const Options& options, size_t threads, std::chrono::steady_clock::time_point start)
+{
+    ObjectOptions objectOptions;
+    objectOptions.ratio = options.ratio;
+    objectOptions.targetFaces = options.faces;
+    objectOptions.budget = options.budget;
+    objectOptions.precision = options.precision;
+    objectOptions.threadCount = threads;
+    objectOptions.pairDistance = options.distance;
+    objectOptions.parallel = options.parallel;
+    objectOptions.cluster = options.cluster;
+
+    size_t inputFaces = data.getFaceCount();
+    ObjectMesh mesh = simplifyObjects(data.getVertices(), data.getIndices(), data.getObjects(), objectOptions);
+
+    if (options.optimize)
+    {
+        // reorder within the objects so their face ranges stay valid
+        for (const MeshObject& object : mesh.objects)
+        {
+            std::span<uint32_t> objectIndices(mesh.indices.data() + 3 * (size_t)object.firstFace, 3 * (size_t)object.faceCount);
+            if (options.overdraw)
+                optimizeOverdraw(objectIndices, mesh.vertices);
+            else
+                optimizeVertexCache(objectIndices, mesh.vertices.size());
+        }
+    }
+
+    MS_TRACE_SCOPE("write");
+    if (!writeMesh(task.output.string(), mesh.vertices, mesh.indices, mesh.objects, threads))
+        return false;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Simplified \"%s\" (%zd objects) from %zd to %zd faces in %.3fs -> \"%s\"\n", task.input.string().c_str(),
+        mesh.objects.size(), inputFaces, mesh.indices.size() / 3, seconds, task.output.string().c_str());
+
+    return true;
+}
+
+// simplify the mesh in chunks without loading it completely
+static bool processStreaming(const Task& task, const Options& options, size_t threads, std::chrono::steady_clock::time_point start)
+{
+    StreamingOptions streaming;
+    streaming.ratio = options.ratio;
+    streaming.targetFaces = options.faces;
+    streaming.memoryBudget = options.memory << 20;
+    streaming.threadCount = threads;
+    streaming.precision = options.precision;
+
+    if (!simplifyStreaming(task.input.string(), task.output.string(), streaming))
+        return false;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Simplified \"%s\" with %zd MB in %.3fs -> \"%s\"\n", task.input.string().c_str(), options.memory,
+        seconds, task.output.string().c_str());
+
+    return true;
+}
+
+// simplify the loaded mesh with a simplifier of any index type and precision and write the result
+template<typename Simplifier>
+static bool processMesh(const Task& task, Simplifier& simplifier, std::vector<glm::vec3>&& vertices, std::vector<uint32_t>&& indices,
+    const Options& options, size_t threads, std::chrono::steady_clock::time_point start)
+{
+    size_t inputFaces = indices.size() / 3;
+    size_t targetFaces = options.faces > 0 ? options.faces : (size_t)(inputFaces * options.ratio);
+
+    simplifier.setThreadCount(threads);
+    simplifier.setPairDistance(options.distance);
+    simplifier.setup(std::move(vertices), std::move(indices));
+
+    // narrower indices are copied, the loaded ones are not needed anymore
+    indices = { };
+
+    if (!options.lods.empty())
+        return processLods(task, simplifier, options, threads, start);
+
+    if (options.cluster)
+        simplifier.runClustered(targetFaces);
+    else if (options.parallel)
+        simplifier.runParallel(targetFaces);
+    else
+        simplifier.run(targetFaces);
+
+    if (options.optimize)
+    {
+        std::vector<glm::vec3> outputVertices(simplifier.getVertices().begin(), simplifier.getVertices().end());
+        std::vector<uint32_t> outputIndices(simplifier.getIndices().begin(), simplifier.getIndices().end());
+
+        MeshOptimizeOptions optimizeOptions;
+        optimizeOptions.overdraw = options.overdraw;
+        MeshOptimizeReport report = optimizeMesh(outputVertices, outputIndices, optimizeOptions);
+        printf("Optimized \"%s\": %zd -> %zd vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", task.input.string().c_str(),
+            report.verticesBefore, report.verticesAfter, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
+        MS_TRACE_SCOPE("write");
+        if (!writeMesh(task.output.string(), outputVertices, outputIndices, {}, threads))
+            return false;
+    }
+    else
+    {
+        MS_TRACE_SCOPE("write");
+        if (!writeMesh(task.output.string(), simplifier.getVertices(), simplifier.getIndices(), {}, threads))
+            return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Simplified \"%s\" from %zd to %zd faces in %.3fs -> \"%s\"\n", task.input.string().c_str(),
+        inputFaces, simplifier.getFaceCount(), seconds, task.output.string().c_str());
+
+    return true;
+}
+
+static bool processTask(const Task& task, const Options& options, size_t threads)
+{
+    MS_TRACE_SCOPE("mesh");
+    auto start = std::chrono::steady_clock::now();
+
+    if (options.memory > 0 && task.input.extension() == ".obj")
+        return processStreaming(task, options, threads, start);
+
+    MeshData data(task.input.string(), options.useCache);
+    if (data.getFaceCount() == 0)
+    {
+        printf("Skipping \"%s\" (no faces).\n", task.input.string().c_str());
+        return false;
+    }
+
+    if (options.weld >= 0.0f)
+    {
+        WeldStats weld = data.weld(options.weld, threads);
+        printf("Welded \"%s\": %zd -> %zd vertices, %zd degenerate faces removed in %.3fs\n", task.input.string().c_str(),
+            weld.inputVertices, weld.outputVertices, weld.degenerateFaces, weld.seconds);
+    }
+
+    if (options.objects)
+        return processObjects(task, data, options, threads, start);
+
+    // the simplifier adopts the loaded buffers, the input is not kept twice
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    data.release(vertices, indices);
+
+    // the simplifier is compiled for 16 and 32 bit indices, the narrowest that fits the mesh is used
+    return visitMeshSimplifier(vertices.size(), options.precision, [&](auto& simplifier)
+        {
+            return processMesh(task, simplifier, std::move(vertices), std::move(indices), options, threads, start);
+        });
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Task> tasks = collectTasks(options);
+    if (tasks.empty())
+    {
+        printf("No input files found.\n");
+        return 1;
+    }
+
+    std::error_code error;
+    for (auto& task : tasks)
+    {
+        if (task.output.has_parent_path())
+            fs::create_directories(task.output.parent_path(), error);
+    }
+
+    // one mesh per worker, the remaining cores are shared by the setup of each mesh
+    size_t jobs = std::min(resolveThreadCount(options.jobs), tasks.size());
+    size_t threads = options.threads > 0 ? options.threads : std::max<size_t>(1, resolveThreadCount(0) / jobs);
+
+    if (!options.trace.empty())
+        traceBegin(options.trace);
+
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> failed = 0;
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < jobs; ++i)
+    {
+        workers.emplace_back([&]()
+            {
+                for (size_t task = next++; task < tasks.size(); task = next++)
+                {
+                    if (!processTask(tasks[task], options, threads))
+                        failed++;
+                }
+            });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    if (traceIsActive())
+        traceEnd();
+
+    printf("Processed %zd meshes (%zd failed).\n", tasks.size(), failed.load());
+    return failed > 0 ? 1 : 0;
+}
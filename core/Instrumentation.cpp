@@ -0,0 +1,118 @@
+#include "Instrumentation.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const char* getPhaseName(StatsPhase phase)
+{
+    switch (phase)
+    {
+    case StatsPhase::Setup:         return "Setup";
+    case StatsPhase::Errors:        return "Quadrics";
+    case StatsPhase::Pairs:         return "Pair creation";
+    case StatsPhase::Heap:          return "Heap";
+    case StatsPhase::RemoveVertex:  return "Remove vertex";
+    case StatsPhase::PairCost:      return "Pair cost";
+    case StatsPhase::Clustering:    return "Clustering";
+    default:                        return "Unknown";
+    }
+}
+
+struct TraceEvent
+{
+    std::string name;
+    size_t thread;
+    double start;       // microseconds since the trace started
+    double duration;    // microseconds
+};
+
+struct TraceState
+{
+    std::mutex mutex;
+    std::atomic<bool> active = false;
+
+    std::string filename;
+    std::chrono::steady_clock::time_point start;
+    std::vector<TraceEvent> events;
+};
+
+static TraceState trace;
+
+bool traceBegin([[maybe_unused]] const std::string& filename)
+{
+#ifdef MS_INSTRUMENT
+    std::lock_guard<std::mutex> lock(trace.mutex);
+
+    trace.filename = filename;
+    trace.start = std::chrono::steady_clock::now();
+    trace.events.clear();
+    trace.active = true;
+
+    return true;
+#else
+    printf("Tracing is not available (compile with MS_INSTRUMENT).\n");
+    return false;
+#endif
+}
+
+// escape quotes and backslashes for json strings
+static std::string escapeJson(const std::string& str)
+{
+    std::string result;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+bool traceEnd()
+{
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (!trace.active) return false;
+
+    trace.active = false;
+
+    FILE* file = fopen(trace.filename.c_str(), "w");
+    if (!file)
+    {
+        printf("Failed to open \"%s\" for writing.\n", trace.filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < trace.events.size(); ++i)
+    {
+        auto& e = trace.events[i];
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%zd,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+            escapeJson(e.name).c_str(), e.thread, e.start, e.duration, i + 1 < trace.events.size() ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+
+    printf("Wrote %zd trace events to \"%s\".\n", trace.events.size(), trace.filename.c_str());
+    trace.events.clear();
+    return true;
+}
+
+bool traceIsActive()
+{
+    return trace.active.load(std::memory_order_relaxed);
+}
+
+void traceEvent(const std::string& name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    size_t thread = std::hash<std::thread::id>{}(std::this_thread::get_id()) % 100000;
+
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (!trace.active) return;
+
+    double begin = std::chrono::duration<double, std::micro>(start - trace.start).count();
+    double duration = std::chrono::duration<double, std::micro>(end - start).count();
+    trace.events.push_back({ name, thread, begin, duration });
+}
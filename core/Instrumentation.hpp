@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+// Statistics and trace events of the simplifier.
+// collecting them is compiled in with MS_INSTRUMENT, otherwise the MS_STATS_* and
+// MS_TRACE_* macros expand to nothing and the statistics stay zero.
+
+#define MS_CONCAT_IMPL(a, b) a##b
+#define MS_CONCAT(a, b) MS_CONCAT_IMPL(a, b)
+
+// phases of the simplifier (phases can be nested, e.g. removeVertex includes the pair costs)
+enum class StatsPhase
+{
+    Setup = 0,      // whole setup()
+    Errors,         // quadric calculation
+    Pairs,          // createValidPairs
+    Heap,           // heap push, pop and rebuild
+    RemoveVertex,   // removeVertex
+    PairCost,       // pair cost calculation
+    Clustering,     // vertex clustering
+    Count
+};
+
+const char* getPhaseName(StatsPhase phase);
+
+struct SimplifierStats
+{
+    // accumulated time of every phase in seconds
+    double time[(size_t)StatsPhase::Count] = { };
+
+    size_t collapses = 0;
+    size_t pairsRecomputed = 0;
+    size_t facesRemoved = 0;
+
+    // peak container sizes
+    size_t peakHeapSize = 0;
+    size_t peakPairCount = 0;
+    size_t peakVertexFaces = 0;     // most faces of a single vertex
+    size_t peakVertexPairs = 0;     // most pairs of a single vertex
+
+    double getTime(StatsPhase phase) const { return time[(size_t)phase]; }
+};
+
+// adds the time until it is destroyed to a phase
+class StatsTimer
+{
+private:
+    SimplifierStats& stats;
+    StatsPhase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    StatsTimer(SimplifierStats& stats, StatsPhase phase)
+        : stats(stats), phase(phase), start(std::chrono::steady_clock::now()) { }
+
+    ~StatsTimer()
+    {
+        stats.time[(size_t)phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// Chrome trace event export (open the file in chrome://tracing or ui.perfetto.dev).
+// events are only recorded between traceBegin and traceEnd.
+
+// start recording, returns false if instrumentation is not compiled in
+bool traceBegin(const std::string& filename);
+
+// stop recording and write the file
+bool traceEnd();
+
+bool traceIsActive();
+
+// record a complete event on the calling thread
+void traceEvent(const std::string& name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+// records an event for its lifetime if a trace is active
+class TraceScope
+{
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    TraceScope(const char* name) : name(name), start(std::chrono::steady_clock::now()) { }
+
+    ~TraceScope()
+    {
+        if (traceIsActive())
+            traceEvent(name, start, std::chrono::steady_clock::now());
+    }
+};
+
+#ifdef MS_INSTRUMENT
+    #define MS_STATS_SCOPE(stats, phase)        StatsTimer MS_CONCAT(statsTimer, __LINE__)(stats, phase)
+    #define MS_STATS_ADD(stats, counter, value) ((stats).counter += (value))
+    #define MS_STATS_MAX(stats, counter, value) ((stats).counter = std::max((stats).counter, (size_t)(value)))
+    #define MS_TRACE_SCOPE(name)                TraceScope MS_CONCAT(traceScope, __LINE__)(name)
+#else
+    #define MS_STATS_SCOPE(stats, phase)        ((void)0)
+    #define MS_STATS_ADD(stats, counter, value) ((void)0)
+    #define MS_STATS_MAX(stats, counter, value) ((void)0)
+    #define MS_TRACE_SCOPE(name)                ((void)0)
+#endif
@@ -0,0 +1,168 @@
+#include "JobSystem.hpp"
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+
+// job system, queue and nesting depth of the job running on the calling thread (always set on workers)
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local size_t currentQueue = 0;
+static thread_local size_t currentDepth = 0;
+
+JobSystem::JobSystem(size_t count)
+{
+    threadCount = resolveThreadCount(count);
+
+    // the thread that waits is one of the threads
+    size_t workerCount = threadCount - 1;
+    for (size_t i = 0; i <= workerCount; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (size_t i = 0; i < workerCount; ++i)
+        workers.emplace_back([this, i]() { workerLoop(i); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void JobSystem::submit(JobCounter& counter, Job job)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        Queue& queue = *queues[getQueueIndex()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({ std::move(job), &counter, getSubmitDepth() });
+    }
+
+    // a worker that just found no job is either waiting or sees the new count
+    queuedJobs.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    // the jobs of the counter were submitted at this level, outer jobs could run much longer than them
+    size_t queue = getQueueIndex();
+    size_t minDepth = getSubmitDepth();
+    while (counter.pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!runJob(queue, minDepth))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::run(const Job& job)
+{
+    JobSystem* previousSystem = currentSystem;
+    size_t previousQueue = currentQueue;
+    size_t previousDepth = currentDepth;
+    currentDepth = getSubmitDepth();
+    currentSystem = this;
+    currentQueue = queues.size() - 1;
+
+    job();
+
+    currentSystem = previousSystem;
+    currentQueue = previousQueue;
+    currentDepth = previousDepth;
+}
+
+JobSystem* JobSystem::current()
+{
+    return currentSystem;
+}
+
+size_t JobSystem::getQueueIndex() const
+{
+    return currentSystem == this ? currentQueue : queues.size() - 1;
+}
+
+size_t JobSystem::getSubmitDepth() const
+{
+    return (currentSystem == this ? currentDepth : 0) + 1;
+}
+
+bool JobSystem::runJob(size_t queue, size_t minDepth)
+{
+    QueuedJob job;
+    bool found = false;
+
+    // newest job of the own queue, the oldest (largest) job of another queue
+    for (size_t i = 0; i < queues.size() && !found; ++i)
+    {
+        Queue& other = *queues[(queue + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+
+        auto deepEnough = [minDepth](const QueuedJob& queued) { return queued.depth >= minDepth; };
+        if (i == 0)
+        {
+            auto it = std::find_if(other.jobs.rbegin(), other.jobs.rend(), deepEnough);
+            if (it == other.jobs.rend())
+                continue;
+
+            job = std::move(*it);
+            other.jobs.erase(std::next(it).base());
+        }
+        else
+        {
+            auto it = std::find_if(other.jobs.begin(), other.jobs.end(), deepEnough);
+            if (it == other.jobs.end())
+                continue;
+
+            job = std::move(*it);
+            other.jobs.erase(it);
+        }
+        found = true;
+    }
+
+    if (!found)
+        return false;
+
+    queuedJobs.fetch_sub(1);
+
+    JobSystem* previousSystem = currentSystem;
+    size_t previousQueue = currentQueue;
+    size_t previousDepth = currentDepth;
+    currentSystem = this;
+    currentQueue = queue;
+    currentDepth = job.depth;
+
+    job.job();
+
+    currentSystem = previousSystem;
+    currentQueue = previousQueue;
+    currentDepth = previousDepth;
+
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(size_t queue)
+{
+    currentSystem = this;
+    currentQueue = queue;
+
+    while (true)
+    {
+        if (runJob(queue, 0))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queuedJobs > 0; });
+        if (stopping && queuedJobs == 0)
+            return;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// unfinished jobs of a group, JobSystem::wait runs jobs until it drops to 0
+struct JobCounter
+{
+    std::atomic<size_t> pending = 0;
+};
+
+// thread pool with one job deque per thread. a thread runs its newest jobs first and steals the
+// oldest jobs of the other threads when it runs out. jobs can submit further jobs and wait for them,
+// waiting threads keep running jobs, so nested waits never block the pool. a nested wait only runs
+// jobs at least as deep as the ones it waits for, so it never picks up a large outer job.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+private:
+    struct QueuedJob
+    {
+        Job job;
+        JobCounter* counter;
+        size_t depth;       // 1 for jobs submitted outside of jobs, one more for every nesting level
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+
+    size_t threadCount = 0;
+    std::vector<std::thread> workers;
+
+    // one queue per worker, the last one is shared by all threads outside of the pool
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> queuedJobs = 0;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+
+public:
+    // threadCount includes the thread calling wait (0 uses all hardware threads)
+    explicit JobSystem(size_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    size_t getThreadCount() const { return threadCount; }
+
+    // queue a job on the queue of the calling thread
+    void submit(JobCounter& counter, Job job);
+
+    // run jobs (own ones first, then stolen ones) until all jobs of the counter finished
+    void wait(JobCounter& counter);
+
+    // run job on the calling thread as a job of this system, so the jobs it submits (e.g. by
+    // parallelFor) are spread over the workers of the pool instead of new threads
+    void run(const Job& job);
+
+    // job system of the job running on the calling thread (nullptr outside of jobs)
+    static JobSystem* current();
+
+private:
+    size_t getQueueIndex() const;
+
+    // nesting level of the jobs submitted by the calling thread
+    size_t getSubmitDepth() const;
+
+    // run one job of at least minDepth of the queue or steal one, returns false if there is none
+    bool runJob(size_t queue, size_t minDepth);
+
+    void workerLoop(size_t queue);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct LodLevel
+{
+    size_t firstIndex;      // first index of the level in LodChain::indices
+    size_t indexCount;
+    size_t vertexCount;     // the level only references vertices [0, vertexCount)
+
+    size_t getFaceCount() const { return indexCount / 3; }
+};
+
+// levels of detail sharing one vertex buffer. levels are ordered from the finest to the
+// coarsest and the vertices are ordered so that coarser levels reference a prefix of them.
+struct LodChain
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<LodLevel> levels;
+
+    std::span<const uint32_t> getIndices(size_t level) const
+    {
+        return { indices.data() + levels[level].firstIndex, levels[level].indexCount };
+    }
+};
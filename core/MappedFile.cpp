@@ -0,0 +1,149 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+{
+    open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(file, other.file);
+#ifdef _WIN32
+        std::swap(mapping, other.mapping);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    file = handle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize))
+    {
+        close();
+        return false;
+    }
+
+    size = (size_t)fileSize.QuadPart;
+    if (size == 0) return true; // empty files can not be mapped
+
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+    {
+        close();
+        return false;
+    }
+
+    data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data)    UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file)    CloseHandle(file);
+
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    file = nullptr;
+}
+
+bool MappedFile::isOpen() const
+{
+    return file != nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0)
+    {
+        close();
+        return false;
+    }
+
+    size = (size_t)info.st_size;
+    if (size == 0) return true; // empty files can not be mapped
+
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = (const char*)mapped;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data)      munmap((void*)data, size);
+    if (file >= 0) ::close(file);
+
+    data = nullptr;
+    size = 0;
+    file = -1;
+}
+
+bool MappedFile::isOpen() const
+{
+    return file >= 0;
+}
+
+#endif
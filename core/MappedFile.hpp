@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // map the file (closes the previous mapping), returns false if the file could not be mapped
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const;
+
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
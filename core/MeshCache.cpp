@@ -0,0 +1,153 @@
+#include "MeshCache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + 15) & ~(uint64_t)15;
+}
+
+bool getMeshCacheSource(const std::string& filename, MeshCacheSource& source)
+{
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filename, error);
+    if (error) return false;
+
+    auto time = std::filesystem::last_write_time(filename, error);
+    if (error) return false;
+
+    source.size = (uint64_t)size;
+    source.time = (int64_t)time.time_since_epoch().count();
+    return true;
+}
+
+// pad from the current position (tracked in a 64 bit counter, ftell is 32 bit on windows) to the offset of the block
+static bool writeBlock(FILE* file, uint64_t& position, uint64_t offset, const void* data, size_t size)
+{
+    static const char padding[16] = { 0 };
+
+    if (position > offset || offset - position > sizeof(padding)) return false;
+
+    size_t paddingSize = (size_t)(offset - position);
+    if (fwrite(padding, 1, paddingSize, file) != paddingSize) return false;
+    if (size != 0 && fwrite(data, 1, size, file) != size) return false;
+
+    position = offset + size;
+    return true;
+}
+
+bool writeMeshCache(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    const MeshCacheSource& source, std::span<const MeshObject> objects)
+{
+    std::vector<MeshCacheObject> cacheObjects;
+    std::string names;
+    for (auto& object : objects)
+    {
+        cacheObjects.push_back({ object.firstFace, object.faceCount, (uint32_t)names.size(), (uint32_t)object.name.size() });
+        names += object.name;
+    }
+
+    MeshCacheHeader header = { };
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.source = source;
+
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+    header.objectCount = cacheObjects.size();
+    header.nameSize = names.size();
+
+    header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + vertices.size_bytes());
+    header.objectOffset = alignOffset(header.indexOffset + indices.size_bytes());
+    header.nameOffset = alignOffset(header.objectOffset + cacheObjects.size() * sizeof(MeshCacheObject));
+
+    std::string tempname = filename + ".tmp";
+    FILE* file = fopen(tempname.c_str(), "wb");
+    if (!file)
+    {
+        printf("Failed to write mesh cache \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    uint64_t position = 0;
+    bool success = writeBlock(file, position, 0, &header, sizeof(MeshCacheHeader))
+        && writeBlock(file, position, header.vertexOffset, vertices.data(), vertices.size_bytes())
+        && writeBlock(file, position, header.indexOffset, indices.data(), indices.size_bytes())
+        && writeBlock(file, position, header.objectOffset, cacheObjects.data(), cacheObjects.size() * sizeof(MeshCacheObject))
+        && writeBlock(file, position, header.nameOffset, names.data(), names.size());
+
+    success = (fclose(file) == 0) && success;
+
+    std::error_code error;
+    if (success)
+        std::filesystem::rename(tempname, filename, error);
+
+    if (!success || error)
+    {
+        std::filesystem::remove(tempname, error);
+        printf("Failed to write mesh cache \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// check that a block lies inside the file and is aligned
+static bool validBlock(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize)
+{
+    if (count == 0) return true;
+    if (offset % 16 != 0 || offset > fileSize) return false;
+    return count <= (fileSize - offset) / elementSize;
+}
+
+bool readMeshCache(const MappedFile& file, MeshCacheView& view, MeshCacheSource* source)
+{
+    view = { };
+
+    size_t size = file.getSize();
+    if (size < sizeof(MeshCacheHeader)) return false;
+
+    const char* data = file.getData();
+    const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+
+    if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION)
+        return false;
+
+    if (header->indexCount % 3 != 0)
+        return false;
+
+    if (!validBlock(header->vertexOffset, header->vertexCount, sizeof(glm::vec3), size)
+        || !validBlock(header->indexOffset, header->indexCount, sizeof(uint32_t), size)
+        || !validBlock(header->objectOffset, header->objectCount, sizeof(MeshCacheObject), size)
+        || !validBlock(header->nameOffset, header->nameSize, 1, size))
+        return false;
+
+    // indices have to reference existing vertices (a truncated or corrupt file would read out of bounds)
+    const uint32_t* indices = (const uint32_t*)(data + header->indexOffset);
+    for (uint64_t i = 0; i < header->indexCount; ++i)
+    {
+        if (indices[i] >= header->vertexCount)
+            return false;
+    }
+
+    // objects have to lie inside the faces and the name block
+    const MeshCacheObject* objects = (const MeshCacheObject*)(data + header->objectOffset);
+    for (uint64_t i = 0; i < header->objectCount; ++i)
+    {
+        if ((uint64_t)objects[i].firstFace + objects[i].faceCount > header->indexCount / 3
+            || (uint64_t)objects[i].nameOffset + objects[i].nameLength > header->nameSize)
+            return false;
+    }
+
+    view.vertices = { (const glm::vec3*)(data + header->vertexOffset), (size_t)header->vertexCount };
+    view.indices = { indices, (size_t)header->indexCount };
+    view.objects = { objects, (size_t)header->objectCount };
+    view.names = { data + header->nameOffset, (size_t)header->nameSize };
+
+    if (source) *source = header->source;
+
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.hpp"
+#include "MeshObject.hpp"
+
+// Binary mesh cache (.msb):
+// a header followed by the raw vertex positions (glm::vec3), the indices (uint32_t) and
+// the object ranges with their names. every block starts at a 16 byte aligned offset,
+// so a mapped file can be used directly.
+
+#define MESH_CACHE_EXTENSION ".msb"
+
+constexpr uint32_t MESH_CACHE_MAGIC = 0x42534d4d; // "MMSB"
+constexpr uint32_t MESH_CACHE_VERSION = 2;
+
+// size and last write time of the file a cache was created from (used to detect stale caches)
+struct MeshCacheSource
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+
+    bool operator==(const MeshCacheSource& other) const { return size == other.size && time == other.time; }
+};
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    MeshCacheSource source;
+
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t objectCount;   // 0 if the mesh has no objects
+    uint64_t nameSize;      // bytes of all object names
+
+    // byte offsets of the blocks from the start of the file
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t objectOffset;
+    uint64_t nameOffset;
+};
+
+// object range of a cache, the name is nameLength bytes at nameOffset in the name block
+struct MeshCacheObject
+{
+    uint32_t firstFace;
+    uint32_t faceCount;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// data of a mapped cache, the spans point into the mapping
+struct MeshCacheView
+{
+    std::span<const glm::vec3> vertices;
+    std::span<const uint32_t> indices;
+    std::span<const MeshCacheObject> objects;
+    std::span<const char> names;
+
+    std::string getObjectName(size_t object) const { return { names.data() + objects[object].nameOffset, objects[object].nameLength }; }
+};
+
+// query size and last write time of a file, returns false if it does not exist
+bool getMeshCacheSource(const std::string& filename, MeshCacheSource& source);
+
+// write a cache file (written to a temporary file first, so readers never see partial files)
+bool writeMeshCache(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    const MeshCacheSource& source = {}, std::span<const MeshObject> objects = {});
+
+// validate the header, the block sizes and the indices of a mapped cache and fill the view,
+// returns false if the file is invalid
+bool readMeshCache(const MappedFile& file, MeshCacheView& view, MeshCacheSource* source = nullptr);
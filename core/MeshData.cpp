@@ -0,0 +1,106 @@
+#include "MeshData.hpp"
+
+#include "Instrumentation.hpp"
+#include "ObjLoader.hpp"
+
+#include <cstdio>
+
+static bool hasExtension(const std::string& filename, const std::string& extension)
+{
+    return filename.size() >= extension.size()
+        && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+MeshData::MeshData(const std::string& filename, bool useCache)
+{
+    MS_TRACE_SCOPE("load");
+
+    if (hasExtension(filename, MESH_CACHE_EXTENSION))
+    {
+        if (!loadCache(filename, nullptr))
+            printf("Failed to load mesh cache \"%s\".\n", filename.c_str());
+        return;
+    }
+
+    // use the sidecar cache if it was created from the current version of the file
+    MeshCacheSource source;
+    std::string cachename = filename + MESH_CACHE_EXTENSION;
+    bool hasSource = getMeshCacheSource(filename, source);
+
+    if (useCache && hasSource && loadCache(cachename, &source))
+        return;
+
+    if (!loadObj(filename, vertexStorage, indexStorage, 0, &objects))
+        return;
+
+    view.vertices = vertexStorage;
+    view.indices = indexStorage;
+
+    printf("Loaded OBJ model \"%s\" ", filename.c_str());
+    printf("with %zd vertices and %zd faces.\n", vertexStorage.size(), indexStorage.size() / 3);
+
+    if (useCache && hasSource)
+        writeMeshCache(cachename, vertexStorage, indexStorage, source, objects);
+}
+
+MeshData::~MeshData()
+{
+}
+
+WeldStats MeshData::weld(float epsilon, size_t threadCount)
+{
+    if (cache.isOpen())
+    {
+        vertexStorage.assign(view.vertices.begin(), view.vertices.end());
+        indexStorage.assign(view.indices.begin(), view.indices.end());
+        cache.close();
+    }
+
+    WeldStats stats = weldVertices(vertexStorage, indexStorage, epsilon, threadCount, objects);
+
+    view = { };
+    view.vertices = vertexStorage;
+    view.indices = indexStorage;
+    return stats;
+}
+
+void MeshData::release(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices)
+{
+    if (cache.isOpen())
+    {
+        vertices.assign(view.vertices.begin(), view.vertices.end());
+        indices.assign(view.indices.begin(), view.indices.end());
+        cache.close();
+    }
+    else
+    {
+        vertices = std::move(vertexStorage);
+        indices = std::move(indexStorage);
+    }
+
+    vertexStorage = { };
+    indexStorage = { };
+    view = { };
+}
+
+bool MeshData::loadCache(const std::string& filename, const MeshCacheSource* source)
+{
+    if (!cache.open(filename))
+        return false;
+
+    MeshCacheSource cacheSource;
+    if (!readMeshCache(cache, view, &cacheSource) || (source && !(cacheSource == *source)))
+    {
+        view = { };
+        cache.close();
+        return false;
+    }
+
+    objects.clear();
+    for (size_t i = 0; i < view.objects.size(); ++i)
+        objects.push_back({ view.getObjectName(i), view.objects[i].firstFace, view.objects[i].faceCount });
+
+    printf("Loaded mesh cache \"%s\" ", filename.c_str());
+    printf("with %zd vertices and %zd faces.\n", getVertexCount(), getFaceCount());
+    return true;
+}
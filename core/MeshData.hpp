@@ -0,0 +1,56 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshCache.hpp"
+#include "VertexWelder.hpp"
+
+// class to load the vertices and indices of an .obj file or a binary mesh cache.
+// parsed .obj files are written to a sidecar cache (filename + ".msb") that is
+// mapped instead of parsing the file again as long as the .obj file is unchanged.
+class MeshData
+{
+private:
+    // data of parsed .obj files
+    std::vector<glm::vec3> vertexStorage;
+    std::vector<uint32_t> indexStorage;
+
+    // face ranges of the objects (empty if the file has none)
+    std::vector<MeshObject> objects;
+
+    // mapped cache file
+    MappedFile cache;
+
+    // views of the data (point into the storage or the mapped cache)
+    MeshCacheView view;
+
+public:
+    MeshData(const std::string& filename, bool useCache = true);
+    ~MeshData();
+
+    MeshData(MeshData&&) = default;
+    MeshData& operator=(MeshData&&) = default;
+
+    std::span<const glm::vec3> getVertices() const { return view.vertices; }
+    std::span<const uint32_t> getIndices() const { return view.indices; }
+
+    std::span<const MeshObject> getObjects() const { return objects; }
+
+    size_t getVertexCount() const { return view.vertices.size(); }
+    size_t getFaceCount() const { return view.indices.size() / 3; }
+
+    // merge vertices at most epsilon apart (see weldVertices), a mapped cache is copied first
+    WeldStats weld(float epsilon, size_t threadCount = 0);
+
+    // move the mesh into the arrays (a mapped cache is copied once), only the objects are kept.
+    // lets a simplifier adopt parsed .obj files without a second copy.
+    void release(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices);
+
+private:
+    // map a binary cache, if source is given the cache has to be created from that source
+    bool loadCache(const std::string& filename, const MeshCacheSource* source);
+};
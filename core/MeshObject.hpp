@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// named range of faces ("o" or "g" statement of an .obj file)
+struct MeshObject
+{
+    std::string name;
+    uint32_t firstFace = 0;
+    uint32_t faceCount = 0;
+};
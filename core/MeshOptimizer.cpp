@@ -0,0 +1,327 @@
+#include "MeshOptimizer.hpp"
+
+#include "Instrumentation.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+constexpr uint32_t INVALID_VERTEX = UINT32_MAX;
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats result;
+    if (indices.empty())
+        return result;
+
+    // a vertex is cached if it was one of the last cacheSize misses
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> used(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t referenced = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (time - cacheTime[index] > cacheSize)
+        {
+            cacheTime[index] = time++;
+            misses++;
+        }
+
+        referenced += used[index] == 0;
+        used[index] = 1;
+    }
+
+    result.acmr = (float)misses / (float)(indices.size() / 3);
+    result.atvr = (float)misses / (float)referenced;
+    return result;
+}
+
+size_t compactVertices(std::vector<glm::vec3>& vertices, std::span<uint32_t> indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), INVALID_VERTEX);
+    for (uint32_t index : indices)
+        remap[index] = 0;
+
+    uint32_t count = 0;
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        if (remap[v] == INVALID_VERTEX)
+            continue;
+
+        remap[v] = count;
+        vertices[count++] = vertices[v];
+    }
+
+    vertices.resize(count);
+    vertices.shrink_to_fit();
+
+    for (uint32_t& index : indices)
+        index = remap[index];
+
+    return count;
+}
+
+// tipsify (Sander, Nehab and Barczak 2007). emits the faces around a fanning vertex and moves on to
+// the adjacent vertex that stays longest in the cache. clusters gets the first face after every dead end.
+static void tipsify(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters)
+{
+    size_t faceCount = indices.size() / 3;
+
+    // faces of every vertex
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+        offsets[index + 1]++;
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<uint32_t> vertexFaces(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            vertexFaces[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    // faces left per vertex
+    std::vector<uint32_t> liveFaces(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveFaces[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(faceCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    deadEnd.reserve(indices.size());
+    output.reserve(indices.size());
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    // continue at the last used vertex with faces left or the next one in input order
+    auto skipDeadEnd = [&]()
+    {
+        while (!deadEnd.empty())
+        {
+            uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveFaces[vertex] > 0)
+                return vertex;
+        }
+
+        for (; cursor < vertexCount; ++cursor)
+        {
+            if (liveFaces[cursor] > 0)
+                return (uint32_t)cursor;
+        }
+
+        return INVALID_VERTEX;
+    };
+
+    uint32_t vertex = skipDeadEnd();
+    while (vertex != INVALID_VERTEX)
+    {
+        if (clusters)
+            clusters->push_back((uint32_t)(output.size() / 3));
+
+        // fan around the vertex until the next one has to be picked from the dead end stack
+        while (vertex != INVALID_VERTEX)
+        {
+            candidates.clear();
+            for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+            {
+                uint32_t face = vertexFaces[i];
+                if (emitted[face])
+                    continue;
+
+                emitted[face] = 1;
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    uint32_t v = indices[3 * face + k];
+                    output.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveFaces[v]--;
+
+                    if (time - cacheTime[v] > cacheSize)
+                        cacheTime[v] = time++;
+                }
+            }
+
+            // the oldest candidate that is still cached after emitting all its faces
+            uint32_t next = INVALID_VERTEX;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates)
+            {
+                if (liveFaces[v] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (time - cacheTime[v] + 2 * liveFaces[v] <= cacheSize)
+                    priority = time - cacheTime[v];
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = v;
+                }
+            }
+
+            vertex = next;
+        }
+
+        vertex = skipDeadEnd();
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    MS_TRACE_SCOPE("vertex cache");
+    tipsify(indices, vertexCount, cacheSize, nullptr);
+}
+
+void optimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> vertices, uint32_t cacheSize, float threshold)
+{
+    MS_TRACE_SCOPE("overdraw");
+
+    size_t faceCount = indices.size() / 3;
+    if (faceCount == 0)
+        return;
+
+    std::vector<uint32_t> hardClusters;
+    tipsify(indices, vertices.size(), cacheSize, &hardClusters);
+    hardClusters.push_back((uint32_t)faceCount);
+
+    // split the clusters as soon as their own acmr (with a cold cache) is low enough
+    float limit = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr * threshold;
+
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> cacheTime(vertices.size(), 0);
+    uint32_t time = cacheSize + 1;
+    for (size_t hard = 0; hard + 1 < hardClusters.size(); ++hard)
+    {
+        uint32_t end = hardClusters[hard + 1];
+        uint32_t clusterStart = hardClusters[hard];
+        size_t misses = 0;
+        clusters.push_back(clusterStart);
+
+        for (uint32_t face = clusterStart; face < end; ++face)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t v = indices[3 * face + k];
+                if (time - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = time++;
+                    misses++;
+                }
+            }
+
+            if (face + 1 < end && (float)misses <= limit * (float)(face + 1 - clusterStart))
+            {
+                clusterStart = face + 1;
+                misses = 0;
+                time += cacheSize + 1;
+                clusters.push_back(clusterStart);
+            }
+        }
+
+        time += cacheSize + 1;
+    }
+    clusters.push_back((uint32_t)faceCount);
+
+    // draw clusters that face away from the center of the mesh first, they occlude the others
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    std::vector<float> areas(clusterCount, 0.0f);
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        for (uint32_t face = clusters[cluster]; face < clusters[cluster + 1]; ++face)
+        {
+            const glm::vec3& p0 = vertices[indices[3 * face + 0]];
+            const glm::vec3& p1 = vertices[indices[3 * face + 1]];
+            const glm::vec3& p2 = vertices[indices[3 * face + 2]];
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+
+            centroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[cluster] += normal;
+            areas[cluster] += area;
+        }
+
+        meshCenter += centroids[cluster];
+        meshArea += areas[cluster];
+
+        if (areas[cluster] > 0.0f)
+            centroids[cluster] /= areas[cluster];
+    }
+
+    if (meshArea > 0.0f)
+        meshCenter /= meshArea;
+
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float length = glm::length(normals[cluster]);
+        sortKeys[cluster] = length > 0.0f ? glm::dot(centroids[cluster] - meshCenter, normals[cluster] / length) : 0.0f;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t cluster : order)
+        output.insert(output.end(), indices.begin() + 3 * clusters[cluster], indices.begin() + 3 * clusters[cluster + 1]);
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+size_t optimizeVertexFetch(std::vector<glm::vec3>& vertices, std::span<uint32_t> indices)
+{
+    MS_TRACE_SCOPE("vertex fetch");
+
+    std::vector<uint32_t> remap(vertices.size(), INVALID_VERTEX);
+    std::vector<glm::vec3> result;
+    result.reserve(vertices.size());
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == INVALID_VERTEX)
+        {
+            remap[index] = (uint32_t)result.size();
+            result.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    result.shrink_to_fit();
+    vertices = std::move(result);
+    return vertices.size();
+}
+
+MeshOptimizeReport optimizeMesh(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, const MeshOptimizeOptions& options)
+{
+    MS_TRACE_SCOPE("optimize");
+
+    MeshOptimizeReport report;
+    report.verticesBefore = vertices.size();
+    report.before = analyzeVertexCache(indices, vertices.size(), options.cacheSize);
+
+    if (options.overdraw)
+        optimizeOverdraw(indices, vertices, options.cacheSize, options.overdrawThreshold);
+    else
+        optimizeVertexCache(indices, vertices.size(), options.cacheSize);
+
+    report.verticesAfter = optimizeVertexFetch(vertices, indices);
+    report.after = analyzeVertexCache(indices, vertices.size(), options.cacheSize);
+    return report;
+}
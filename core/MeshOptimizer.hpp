@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// post-transform vertex cache efficiency of an index buffer (simulated fifo cache)
+struct VertexCacheStats
+{
+    float acmr = 0.0f;  // average cache miss ratio (transformed vertices per triangle, 0.5 - 3)
+    float atvr = 0.0f;  // average transformed vertex ratio (transformed per referenced vertex, 1 is optimal)
+};
+
+struct MeshOptimizeOptions
+{
+    uint32_t cacheSize = 16;        // entries of the simulated vertex cache
+    bool overdraw = false;          // reorder clusters of triangles to reduce overdraw
+    float overdrawThreshold = 1.05f;// acmr the overdraw pass may lose (1.05 allows 5% more misses)
+};
+
+struct MeshOptimizeReport
+{
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+// remove vertices that are not referenced by any face and remap the indices (keeps the vertex order).
+// returns the new vertex count.
+size_t compactVertices(std::vector<glm::vec3>& vertices, std::span<uint32_t> indices);
+
+// reorder the faces for the post-transform vertex cache (tipsify)
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+// reorder the faces for the vertex cache (includes optimizeVertexCache) and then sort clusters
+// of them so outward facing parts are drawn first. clusters are only split as long as their
+// acmr stays below threshold times the acmr of the cache optimized order.
+void optimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> vertices, uint32_t cacheSize = 16, float threshold = 1.05f);
+
+// renumber the vertices in the order the faces use them (drops unreferenced vertices).
+// returns the new vertex count.
+size_t optimizeVertexFetch(std::vector<glm::vec3>& vertices, std::span<uint32_t> indices);
+
+// run all passes on a simplified mesh: vertex cache, overdraw (optional) and vertex fetch
+MeshOptimizeReport optimizeMesh(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, const MeshOptimizeOptions& options = { });
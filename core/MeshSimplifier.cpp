@@ -0,0 +1,3 @@
+#include "MeshSimplifierImpl.hpp"
+
+template class BasicMeshSimplifier<uint32_t, float>;
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Instrumentation.hpp"
+#include "LodChain.hpp"
+#include "ProgressiveMesh.hpp"
+#include "Quadric.hpp"
+
+// two vertices that can be collapsed, the cost and target position are stored next to the pairs
+template<typename Index>
+struct VertexPair
+{
+    Index first;
+    Index second;
+
+    // incremented whenever the cost changes (heap entries with an older version are stale)
+    uint32_t version = 0;
+    bool removed = false;
+
+    bool operator==(const VertexPair& other) const
+    {
+        return (first == other.first && second == other.second)
+            || (second == other.first && first == other.second);
+    }
+};
+
+// changes of a single collapse that are applied after the collapse (face removal and logging)
+struct CollapseOutput
+{
+    std::vector<uint32_t> faces;    // detached faces
+    std::vector<uint32_t> pairs;    // pairs flagged as removed
+    std::vector<uint32_t> faceIds;  // input face ids of the detached faces (only while recording)
+    std::vector<uint32_t> corners;  // changed corners (only while recording)
+
+    void clear()
+    {
+        faces.clear();
+        pairs.clear();
+        faceIds.clear();
+        corners.clear();
+    }
+};
+
+// scratch arrays of a batched pair cost evaluation
+template<typename Scalar>
+struct PairCostBatch
+{
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    std::vector<glm::vec3> positions;
+    std::vector<Scalar> costs;
+};
+
+// entry of the priority queue, refers to a pair by its index
+template<typename Scalar>
+struct HeapEntry
+{
+    Scalar cost;
+    uint32_t pair;
+    uint32_t version;
+};
+
+struct HeapEntryComp
+{
+    template<typename Scalar>
+    bool operator()(const HeapEntry<Scalar>& e1, const HeapEntry<Scalar>& e2) const
+    {
+        return (e2.cost < e1.cost);
+    }
+};
+
+// scratch arrays of runParallel, kept between rounds and runs to avoid reallocations
+template<typename Scalar>
+struct ParallelScratch
+{
+    // collapse of the current batch
+    struct Collapse
+    {
+        uint32_t pair;
+        CollapseRecord record;
+        CollapseOutput output;
+    };
+
+    std::vector<Collapse> batch;
+    std::vector<HeapEntry<Scalar>> rejected;
+    std::vector<uint32_t> ring;
+    std::vector<uint32_t> removedFaces;
+    std::vector<uint32_t> updated;
+
+    // vertices in the 1-ring of an accepted collapse are marked with the round
+    std::vector<uint32_t> marks;
+    uint32_t round = 0;
+};
+
+// uniform grid of the vertices with faces, finds the vertices within the pair distance.
+// cells are twice as large as the distance, so the neighbours of a vertex are in its own cell
+// and the 7 cells next to the closer half of it along each axis.
+struct VertexGrid
+{
+    float distance = 0.0f;
+    float cellSize = 0.0f;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<uint64_t> vertexCells;  // cell of every vertex (kept up to date when vertices move)
+};
+
+// Garland-Heckbert edge collapse simplifier, compiled for one index type (uint16_t or uint32_t vertex ids)
+// and one quadric precision (float or double). each of the four variants is instantiated in its own MeshSimplifier*.cpp.
+// face and pair ids stay 32 bit, a mesh with 16 bit indices can still have more than 65536 faces.
+template<typename Index, typename Scalar>
+class BasicMeshSimplifier
+{
+    static_assert(std::is_same_v<Index, uint16_t> || std::is_same_v<Index, uint32_t>, "indices have to be uint16_t or uint32_t");
+    static_assert(std::is_same_v<Scalar, float> || std::is_same_v<Scalar, double>, "quadrics have to be float or double");
+
+public:
+    using IndexType = Index;
+    using ScalarType = Scalar;
+    using QuadricType = BasicQuadric<Scalar>;
+
+    static constexpr uint32_t INVALID_PAIR = UINT32_MAX;
+    static constexpr uint32_t REMOVED_FACE = UINT32_MAX;
+    static constexpr uint32_t REMOVED_VERTEX = UINT32_MAX;
+
+    // vertices that the indices can address
+    static constexpr size_t MAX_VERTICES = (size_t)std::numeric_limits<Index>::max() + 1;
+
+    // called while running from the running thread, returning false stops the run early
+    using ProgressCallback = std::function<bool(const BasicMeshSimplifier&)>;
+
+private:
+    // removed faces stay in place as degenerate faces with the face id REMOVED_FACE until
+    // compactFaces() drops them (at the end of every run or when half of the faces are removed)
+    std::vector<Index> indices;
+    std::vector<uint32_t> faceIds;  // input face id of every face
+    size_t removedFaceCount = 0;
+
+    // vertex data
+    std::vector<glm::vec3> vertices;
+    std::vector<QuadricType> errors;
+    std::vector<uint8_t> locked;    // locked vertices keep their position and are never removed
+
+    // adjacency of every vertex (kept up to date during collapses)
+    std::vector<std::vector<uint32_t>> vertexFaces;
+    std::vector<std::vector<uint32_t>> vertexPairs;
+
+    // all valid pairs (removed pairs are only flagged to keep the indices stable until compactPairs())
+    std::vector<VertexPair<Index>> pairs;
+    size_t removedPairCount = 0;
+
+    // removed pairs whose slots can be reused by new pairs (cleared by compactPairs())
+    std::vector<uint32_t> freePairs;
+
+    // cost and position after the collapse of every pair
+    std::vector<Scalar> pairCosts;
+    std::vector<glm::vec3> pairPositions;
+
+    // min heap of pair costs, outdated entries are skipped when they are popped
+    std::vector<HeapEntry<Scalar>> heap;
+
+    // threads used by setup (0 uses all hardware threads)
+    size_t threadCount = 0;
+
+    // vertices closer than this are paired even without an edge (0 only pairs edges)
+    float pairDistance = 0.0f;
+    VertexGrid vertexGrid;
+
+    // collapses of run() are logged while recording is enabled
+    bool recording = false;
+    CollapseLog log;
+
+    // reused by removeVertex and runParallel
+    CollapseOutput collapseScratch;
+    PairCostBatch<Scalar> pairCostScratch;
+    ParallelScratch<Scalar> parallelScratch;
+
+    // called every progressInterval collapses (every round of runParallel)
+    ProgressCallback progressCallback;
+    size_t progressInterval = 1024;
+
+    // statistics since the last setup (only collapses are counted without MS_INSTRUMENT)
+    SimplifierStats stats;
+
+public:
+    BasicMeshSimplifier() = default;
+    BasicMeshSimplifier(std::span<const glm::vec3> vertices, std::span<const Index> indices);
+    BasicMeshSimplifier(std::vector<glm::vec3>&& vertices, std::vector<Index>&& indices);
+    ~BasicMeshSimplifier();
+
+    // prepare the algorithm (calculate errors and create pairs).
+    // the span version copies the mesh once, the vector version adopts the buffers.
+    void setup(std::span<const glm::vec3> vertices, std::span<const Index> indices);
+    void setup(std::vector<glm::vec3>&& vertices, std::vector<Index>&& indices);
+
+    // 32 bit indices are narrowed while they are copied (the mesh must have at most MAX_VERTICES vertices)
+    void setup(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices) requires (!std::is_same_v<Index, uint32_t>);
+    void setup(std::vector<glm::vec3>&& vertices, std::span<const uint32_t> indices) requires (!std::is_same_v<Index, uint32_t>);
+
+    // run the algorithm until the face count is less than or equal to targetFaces
+    void run(size_t targetFaces);
+
+    // same as run, but every round collapses a batch of the cheapest pairs with non overlapping
+    // neighbourhoods concurrently. batchSize limits the candidates per round (0 picks one by thread count)
+    void runParallel(size_t targetFaces, size_t batchSize = 0);
+
+    // merge all vertices in the same cell of a uniform grid with resolution cells along the longest side.
+    // every cluster is placed at the minimum of its summed quadrics and degenerate faces are dropped.
+    // vertices without faces (removed by earlier collapses) are dropped.
+    // the collapse log is cleared, run() can continue from the clustered mesh.
+    // returns the cluster of every previous vertex (REMOVED_VERTEX for dropped vertices).
+    std::vector<uint32_t> cluster(uint32_t resolution);
+
+    // cluster on a grid that keeps a little more than targetFaces faces and finish with run().
+    // returns the cluster of every input vertex like cluster() (empty if nothing was clustered).
+    std::vector<uint32_t> runClustered(size_t targetFaces);
+
+    // run once through all target face counts (in any order) and snapshot every level.
+    // the simplifier is left at the coarsest level.
+    LodChain buildLods(std::span<const size_t> targetFaces);
+
+    // same as buildLods with targets relative to the current face count
+    LodChain buildLodsByRatio(std::span<const float> ratios);
+    
+    // views of the current mesh, valid until the next change of the simplifier.
+    // while running, removed faces are still in the indices as degenerate faces.
+    std::span<const glm::vec3> getVertices() const { return vertices; }
+    std::span<const Index> getIndices() const { return indices; }
+
+    // lock vertices of the next setup (flags per vertex, missing flags are unlocked).
+    // pairs between two locked vertices never collapse, other pairs keep the locked vertex.
+    void setLockedVertices(std::vector<uint8_t> flags) { locked = std::move(flags); }
+    bool isLocked(uint32_t vertex) const { return locked[vertex] != 0; }
+
+    // the mesh is consistent while the callback runs, it can be copied (but not changed)
+    void setProgressCallback(ProgressCallback callback, size_t interval = 1024) { progressCallback = std::move(callback); progressInterval = std::max<size_t>(1, interval); }
+
+    // pair vertices closer than distance even if no edge connects them (Garland-Heckbert), from the next setup.
+    // disconnected parts can merge then. the pairs are found with a uniform grid and new ones are
+    // added when collapses move vertices close to each other. 0 only pairs the edges of the mesh.
+    void setPairDistance(float distance) { pairDistance = std::max(distance, 0.0f); }
+    float getPairDistance() const { return pairDistance; }
+
+    void setThreadCount(size_t count) { threadCount = count; }
+    size_t getThreadCount() const { return threadCount; }
+
+    // record the collapses of the following runs (the log is cleared by setup)
+    void setRecording(bool enabled) { recording = enabled; }
+    bool isRecording() const { return recording; }
+    const CollapseLog& getCollapseLog() const { return log; }
+
+    size_t getCollapseCount() const { return stats.collapses; }
+    const SimplifierStats& getStats() const { return stats; }
+
+    size_t getPairCount() const { return pairs.size() - removedPairCount; }
+    size_t getHeapSize() const { return heap.size(); }
+
+    // size of the vertex array, collapsed vertices stay in it until the mesh is compacted
+    size_t getVertexCount() const { return vertices.size(); }
+    size_t getFaceCount() const { return indices.size() / 3 - removedFaceCount; }
+
+    // vertices that are still used by a face
+    size_t getLiveVertexCount() const;
+
+    // debug print functions
+    void printPairs();
+    void printFaces();
+
+private:
+    // fill vertexFaces with the faces of every vertex
+    void buildAdjacency();
+
+    // build adjacency, pairs and heap for the current faces and errors
+    void buildPairs();
+
+    // create all valid pairs
+    void createValidPairs();
+
+    // fill the vertex grid and create the pairs of vertices within pairDistance that have no edge
+    void createDistancePairs();
+
+    // move the kept vertex of a collapse in the grid, drop the removed one and pair the kept vertex with
+    // the vertices that are within pairDistance now (the costs of the new pairs are not set)
+    void updateDistancePairs(uint32_t newVertex, uint32_t removedVertex);
+
+    // add a pair (reuses the slot of a removed pair if there is one), returns its index
+    uint32_t addPair(uint32_t v0, uint32_t v1);
+
+    // find the pair connecting v0 and v1 (returns INVALID_PAIR if there is none)
+    uint32_t findPair(uint32_t v0, uint32_t v1) const;
+
+    // set the costs and positions of the pairs (evaluated in batches by the quadric kernels)
+    void setPairCosts(std::span<const uint32_t> ids, PairCostBatch<Scalar>& batch);
+
+    // recalculate the costs of the pairs and push their new versions onto the heap
+    void updatePairs(std::span<const uint32_t> ids);
+
+    // push a new version of the pair with its current cost onto the heap
+    void pushPair(uint32_t pair);
+
+    // rebuild the heap from all valid pairs (drops stale entries)
+    void rebuildHeap();
+
+    // calculate the quadric error matrix of every vertex
+    void calculateErrors();
+
+    // flag detached faces as removed and make them degenerate
+    void removeFaces(std::span<const uint32_t> faces);
+
+    // drop the removed faces and renumber the faces of the vertices
+    void compactFaces();
+
+    // drop the removed pairs, renumber the pairs of the vertices and rebuild the heap
+    void compactPairs();
+
+    // replace removedVertex with newVertex, faces containing both are only detached and returned in output.
+    // only the neighbourhood of both vertices is touched (no heap or face removal).
+    void collapseVertex(uint32_t newVertex, uint32_t removedVertex, CollapseOutput& output);
+
+    // remove removedVertex (or replace it with newVertex) and repair the mesh afterwards
+    void removeVertex(uint32_t newVertex, uint32_t removedVertex);
+
+    // collect both vertices and all vertices sharing a face or pair with them (may contain duplicates)
+    void gatherRing(uint32_t v0, uint32_t v1, std::vector<uint32_t>& ring) const;
+
+    // number of faces containing both vertices
+    size_t countSharedFaces(uint32_t v0, uint32_t v1) const;
+};
+
+extern template class BasicMeshSimplifier<uint16_t, float>;
+extern template class BasicMeshSimplifier<uint32_t, float>;
+extern template class BasicMeshSimplifier<uint16_t, double>;
+extern template class BasicMeshSimplifier<uint32_t, double>;
+
+// 32 bit indices with float quadrics, fits every mesh
+using MeshSimplifier = BasicMeshSimplifier<uint32_t, float>;
+
+// call func with a simplifier of the narrowest index type that can address vertexCount vertices and
+// the given precision. the variant is picked once here, func is compiled for each of them (a generic
+// lambda) and returns the same type for all.
+template<typename Func>
+auto visitMeshSimplifier(size_t vertexCount, QuadricPrecision precision, Func&& func)
+{
+    bool shortIndices = vertexCount <= BasicMeshSimplifier<uint16_t, float>::MAX_VERTICES;
+    if (precision == QuadricPrecision::Double)
+    {
+        if (shortIndices)
+        {
+            BasicMeshSimplifier<uint16_t, double> simplifier;
+            return func(simplifier);
+        }
+
+        BasicMeshSimplifier<uint32_t, double> simplifier;
+        return func(simplifier);
+    }
+
+    if (shortIndices)
+    {
+        BasicMeshSimplifier<uint16_t, float> simplifier;
+        return func(simplifier);
+    }
+
+    BasicMeshSimplifier<uint32_t, float> simplifier;
+    return func(simplifier);
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include "MeshSimplifierImpl.hpp"
+
+template class BasicMeshSimplifier<uint16_t, float>;
@@ -0,0 +1,1248 @@
+#pragma once
+
+// definitions of BasicMeshSimplifier, only included by the files that instantiate one variant each.
+// the variants are kept in separate files so the inliner optimizes every one of them on its own
+// (with several variants in one file, shared helpers have more callers and stop being inlined).
+
+#include "MeshSimplifier.hpp"
+
+#include "Parallel.hpp"
+#include "QuadricKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+// remove the first occurrence of value from the list (order is not preserved)
+static void eraseValue(std::vector<uint32_t>& list, uint32_t value)
+{
+    auto it = std::find(list.begin(), list.end(), value);
+    if (it == list.end()) return;
+
+    *it = list.back();
+    list.pop_back();
+}
+
+// uniform grid over the bounding box of a mesh
+struct ClusterGrid
+{
+    static constexpr uint32_t MAX_RESOLUTION = (1 << 21) - 1;
+
+    // locked vertices get a cell of their own (getCell never sets bit 63)
+    static constexpr uint64_t LOCKED_CELL = 1ull << 63;
+
+    glm::vec3 min = glm::vec3(0.0f);
+    float cellSize = 1.0f;
+    uint32_t size[3] = { 1, 1, 1 };
+
+    ClusterGrid(std::span<const glm::vec3> vertices, uint32_t resolution)
+    {
+        if (vertices.empty())
+            return;
+
+        glm::vec3 max = vertices[0];
+        min = vertices[0];
+        for (auto& v : vertices)
+        {
+            min = glm::min(min, v);
+            max = glm::max(max, v);
+        }
+
+        glm::vec3 extent = max - min;
+        float longest = std::max(extent.x, std::max(extent.y, extent.z));
+
+        resolution = std::clamp<uint32_t>(resolution, 1, MAX_RESOLUTION);
+        cellSize = longest > 0.0f ? longest / resolution : 1.0f;
+
+        for (int i = 0; i < 3; ++i)
+            size[i] = std::clamp<uint32_t>((uint32_t)std::ceil(extent[i] / cellSize), 1, MAX_RESOLUTION);
+    }
+
+    // cell key of a position (21 bits per axis)
+    uint64_t getCell(glm::vec3 p) const
+    {
+        uint64_t key = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            float cell = std::floor((p[i] - min[i]) / cellSize);
+            uint64_t c = (uint64_t)std::clamp(cell, 0.0f, (float)(size[i] - 1));
+            key |= c << (21 * i);
+        }
+        return key;
+    }
+
+    void getCells(std::span<const glm::vec3> vertices, std::span<const uint8_t> locked, size_t threadCount, std::vector<uint64_t>& cells) const
+    {
+        cells.resize(vertices.size());
+        parallelFor(vertices.size(), threadCount, [&](size_t v) { cells[v] = locked[v] ? LOCKED_CELL | v : getCell(vertices[v]); });
+    }
+};
+
+// number of faces whose corners lie in three different cells
+template<typename Index>
+static size_t countClusteredFaces(std::span<const Index> indices, const std::vector<uint64_t>& cells, size_t threadCount)
+{
+    size_t faceCount = indices.size() / 3;
+
+    std::vector<size_t> chunkCounts(getChunkCount(faceCount, threadCount), 0);
+    parallelForChunks(faceCount, threadCount, [&](size_t chunk, size_t begin, size_t end)
+        {
+            for (size_t face = begin; face < end; ++face)
+            {
+                uint64_t c0 = cells[indices[3 * face]];
+                uint64_t c1 = cells[indices[3 * face + 1]];
+                uint64_t c2 = cells[indices[3 * face + 2]];
+                if (c0 != c1 && c1 != c2 && c0 != c2)
+                    chunkCounts[chunk]++;
+            }
+        });
+
+    size_t count = 0;
+    for (size_t c : chunkCounts)
+        count += c;
+    return count;
+}
+
+// cell of a position in the vertex grid (21 bits per axis that wrap around, vertices of wrapped
+// cells are only extra candidates that the distance test rejects)
+static constexpr uint64_t GRID_AXIS_MASK = (1 << 21) - 1;
+
+static uint64_t getGridCell(glm::vec3 p, float cellSize)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        float cell = std::clamp(std::floor(p[i] / cellSize), -1e15f, 1e15f);
+        key |= ((uint64_t)(int64_t)cell & GRID_AXIS_MASK) << (21 * i);
+    }
+    return key;
+}
+
+static uint64_t offsetGridCell(uint64_t cell, int dx, int dy, int dz)
+{
+    int offsets[3] = { dx, dy, dz };
+
+    uint64_t key = 0;
+    for (int i = 0; i < 3; ++i)
+        key |= (((cell >> (21 * i)) + (uint64_t)(int64_t)offsets[i]) & GRID_AXIS_MASK) << (21 * i);
+    return key;
+}
+
+// call func(other) for every vertex of the grid within the distance of the vertex
+template<typename Func>
+static void forEachNearVertex(const VertexGrid& grid, std::span<const glm::vec3> vertices, uint32_t vertex, Func func)
+{
+    glm::vec3 position = vertices[vertex];
+    uint64_t cell = grid.vertexCells[vertex];
+    float maxDistance2 = grid.distance * grid.distance;
+
+    // the side of the neighbour cell along each axis
+    int sides[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        float p = position[i] / grid.cellSize;
+        sides[i] = p - std::floor(p) < 0.5f ? -1 : 1;
+    }
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        uint64_t key = offsetGridCell(cell, corner & 1 ? sides[0] : 0, corner & 2 ? sides[1] : 0, corner & 4 ? sides[2] : 0);
+        auto it = grid.cells.find(key);
+        if (it == grid.cells.end())
+            continue;
+
+        for (uint32_t other : it->second)
+        {
+            glm::vec3 d = vertices[other] - position;
+            if (other != vertex && glm::dot(d, d) <= maxDistance2)
+                func(other);
+        }
+    }
+}
+
+static void removeFromGrid(VertexGrid& grid, uint32_t vertex)
+{
+    auto it = grid.cells.find(grid.vertexCells[vertex]);
+    if (it == grid.cells.end())
+        return;
+
+    eraseValue(it->second, vertex);
+    if (it->second.empty())
+        grid.cells.erase(it);
+}
+
+template<typename Index, typename Scalar>
+BasicMeshSimplifier<Index, Scalar>::BasicMeshSimplifier(std::span<const glm::vec3> vertices, std::span<const Index> indices)
+{
+    setup(vertices, indices);
+}
+
+template<typename Index, typename Scalar>
+BasicMeshSimplifier<Index, Scalar>::BasicMeshSimplifier(std::vector<glm::vec3>&& vertices, std::vector<Index>&& indices)
+{
+    setup(std::move(vertices), std::move(indices));
+}
+
+template<typename Index, typename Scalar>
+BasicMeshSimplifier<Index, Scalar>::~BasicMeshSimplifier() { }
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::setup(std::span<const glm::vec3> v, std::span<const Index> i)
+{
+    setup(std::vector<glm::vec3>(v.begin(), v.end()), std::vector<Index>(i.begin(), i.end()));
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::setup(std::span<const glm::vec3> v, std::span<const uint32_t> i) requires (!std::is_same_v<Index, uint32_t>)
+{
+    setup(std::vector<glm::vec3>(v.begin(), v.end()), std::vector<Index>(i.begin(), i.end()));
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::setup(std::vector<glm::vec3>&& v, std::span<const uint32_t> i) requires (!std::is_same_v<Index, uint32_t>)
+{
+    setup(std::move(v), std::vector<Index>(i.begin(), i.end()));
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::setup(std::vector<glm::vec3>&& v, std::vector<Index>&& i)
+{
+    stats = { };
+    MS_STATS_SCOPE(stats, StatsPhase::Setup);
+    MS_TRACE_SCOPE("setup");
+
+    vertices = std::move(v);
+    indices = std::move(i);
+    locked.resize(vertices.size(), 0);
+    log.clear();
+
+    removedFaceCount = 0;
+    faceIds.resize(getFaceCount());
+    for (uint32_t face = 0; face < getFaceCount(); ++face)
+        faceIds[face] = face;
+
+    buildAdjacency();
+
+    // calc the Quadric Error for every vertex
+    calculateErrors();
+
+    buildPairs();
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::buildPairs()
+{
+    // create all valid pairs
+    createValidPairs();
+
+    // set the error for each pair
+    {
+        MS_STATS_SCOPE(stats, StatsPhase::PairCost);
+        MS_TRACE_SCOPE("pair costs");
+        parallelForChunks(pairs.size(), threadCount, [this](size_t, size_t begin, size_t end)
+            {
+                PairCostBatch<Scalar> batch;
+                std::vector<uint32_t> ids(end - begin);
+                std::iota(ids.begin(), ids.end(), (uint32_t)begin);
+                setPairCosts(ids, batch);
+            });
+    }
+
+    rebuildHeap();
+
+    MS_STATS_MAX(stats, peakPairCount, pairs.size());
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::run(size_t targetFaces)
+{
+    MS_TRACE_SCOPE("run");
+
+    while (getFaceCount() > targetFaces && !heap.empty())
+    {
+        if (removedPairCount > pairs.size() / 2)
+            compactPairs();
+
+        // get and remove the edge with minimal error
+        HeapEntry<Scalar> entry;
+        {
+            MS_STATS_SCOPE(stats, StatsPhase::Heap);
+            std::pop_heap(heap.begin(), heap.end(), HeapEntryComp());
+            entry = heap.back();
+            heap.pop_back();
+        }
+
+        // skip entries of removed pairs or pairs whose cost changed since the entry was pushed
+        VertexPair<Index>& removedPair = pairs[entry.pair];
+        if (removedPair.removed || removedPair.version != entry.version)
+            continue;
+
+        // only pairs between two locked vertices are left
+        if (std::isinf(entry.cost))
+            break;
+
+        uint32_t newVertex = removedPair.first;
+        uint32_t removedVertex = removedPair.second;
+
+        if (recording)
+        {
+            CollapseRecord record = { newVertex, removedVertex, vertices[newVertex], pairPositions[entry.pair], (float)pairCosts[entry.pair],
+                (uint32_t)log.faces.size(), 0, (uint32_t)log.corners.size(), 0 };
+            log.collapses.push_back(record);
+        }
+
+        // set the error and position of the new vertex.
+        errors[newVertex] += errors[removedVertex];
+        vertices[newVertex] = pairPositions[entry.pair];
+
+        // replace removedVertex with newVertex
+        removeVertex(newVertex, removedVertex);
+        stats.collapses++;
+
+        if (recording)
+        {
+            CollapseRecord& record = log.collapses.back();
+            record.faceCount = (uint32_t)log.faces.size() - record.firstFace;
+            record.cornerCount = (uint32_t)log.corners.size() - record.firstCorner;
+        }
+
+        if (progressCallback && stats.collapses % progressInterval == 0 && !progressCallback(*this))
+            break;
+    }
+
+    compactFaces();
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::runParallel(size_t targetFaces, size_t batchSize)
+{
+    // every round runs short parallel loops that would start and join new threads each time outside
+    // of a job system, keep one pool of threads for the whole run instead
+    if (!JobSystem::current() && resolveThreadCount(threadCount) > 1)
+    {
+        JobSystem jobs(threadCount);
+        jobs.run([=, this]() { runParallel(targetFaces, batchSize); });
+        return;
+    }
+
+    MS_TRACE_SCOPE("run parallel");
+
+    if (batchSize == 0)
+        batchSize = 256 * resolveThreadCount(threadCount);
+
+    auto& batch = parallelScratch.batch;
+    auto& rejected = parallelScratch.rejected;
+    auto& ring = parallelScratch.ring;
+    auto& removedFaces = parallelScratch.removedFaces;
+    auto& updated = parallelScratch.updated;
+    auto& marks = parallelScratch.marks;
+    uint32_t& round = parallelScratch.round;
+    marks.resize(vertices.size(), 0);
+
+    while (getFaceCount() > targetFaces && !heap.empty())
+    {
+        if (removedPairCount > pairs.size() / 2)
+            compactPairs();
+
+        round++;
+        size_t batchCount = 0;
+        size_t removing = 0;
+        rejected.clear();
+
+        // select the cheapest pairs whose neighbourhoods do not overlap
+        {
+            MS_STATS_SCOPE(stats, StatsPhase::Heap);
+
+            size_t candidates = 0;
+            while (!heap.empty() && candidates < batchSize && getFaceCount() - removing > targetFaces)
+            {
+                std::pop_heap(heap.begin(), heap.end(), HeapEntryComp());
+                HeapEntry<Scalar> entry = heap.back();
+                heap.pop_back();
+
+                const VertexPair<Index>& p = pairs[entry.pair];
+                if (p.removed || p.version != entry.version)
+                    continue;
+
+                // only pairs between two locked vertices are left
+                if (std::isinf(entry.cost))
+                {
+                    heap.clear();
+                    break;
+                }
+
+                candidates++;
+
+                gatherRing(p.first, p.second, ring);
+                if (std::any_of(ring.begin(), ring.end(), [&marks, round](uint32_t v) { return marks[v] == round; }))
+                {
+                    rejected.push_back(entry);
+                    continue;
+                }
+
+                for (uint32_t v : ring)
+                    marks[v] = round;
+
+                removing += countSharedFaces(p.first, p.second);
+
+                if (batchCount == batch.size())
+                    batch.emplace_back();
+
+                batch[batchCount++].pair = entry.pair;
+            }
+
+            // the rejected pairs are still valid
+            for (auto& entry : rejected)
+            {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), HeapEntryComp());
+            }
+        }
+
+        // the collapses only touch their own neighbourhood and can run concurrently
+        {
+            MS_STATS_SCOPE(stats, StatsPhase::RemoveVertex);
+
+            parallelFor(batchCount, threadCount, [this, &batch](size_t i)
+                {
+                    typename ParallelScratch<Scalar>::Collapse& collapse = batch[i];
+                    VertexPair<Index>& p = pairs[collapse.pair];
+
+                    uint32_t newVertex = p.first;
+                    uint32_t removedVertex = p.second;
+
+                    if (recording)
+                        collapse.record = { newVertex, removedVertex, vertices[newVertex], pairPositions[collapse.pair], (float)pairCosts[collapse.pair], 0, 0, 0, 0 };
+
+                    errors[newVertex] += errors[removedVertex];
+                    vertices[newVertex] = pairPositions[collapse.pair];
+
+                    collapse.output.clear();
+                    collapseVertex(newVertex, removedVertex, collapse.output);
+                });
+
+            removedFaces.clear();
+            for (size_t i = 0; i < batchCount; ++i)
+            {
+                typename ParallelScratch<Scalar>::Collapse& collapse = batch[i];
+                removedFaces.insert(removedFaces.end(), collapse.output.faces.begin(), collapse.output.faces.end());
+                removedPairCount += collapse.output.pairs.size();
+
+                if (recording)
+                {
+                    CollapseRecord& record = collapse.record;
+                    record.firstFace = (uint32_t)log.faces.size();
+                    record.faceCount = (uint32_t)collapse.output.faceIds.size();
+                    record.firstCorner = (uint32_t)log.corners.size();
+                    record.cornerCount = (uint32_t)collapse.output.corners.size();
+
+                    log.collapses.push_back(record);
+                    log.faces.insert(log.faces.end(), collapse.output.faceIds.begin(), collapse.output.faceIds.end());
+                    log.corners.insert(log.corners.end(), collapse.output.corners.begin(), collapse.output.corners.end());
+                }
+            }
+
+            removeFaces(removedFaces);
+            stats.collapses += batchCount;
+        }
+
+        // recalculate the costs of the touched pairs in parallel and push them serially
+        updated.clear();
+        for (size_t i = 0; i < batchCount; ++i)
+        {
+            uint32_t newVertex = pairs[batch[i].pair].first;
+            if (pairDistance > 0.0f)
+                updateDistancePairs(newVertex, pairs[batch[i].pair].second);
+
+            updated.insert(updated.end(), vertexPairs[newVertex].begin(), vertexPairs[newVertex].end());
+        }
+
+        // a pair between two vertices of the batch is reached from both of them (only possible for
+        // distance pairs, the neighbourhoods of the batch do not overlap otherwise)
+        if (pairDistance > 0.0f)
+        {
+            std::sort(updated.begin(), updated.end());
+            updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+        }
+
+        // freed after the new pairs, the collapsed pairs of the batch are still read above
+        for (size_t i = 0; i < batchCount; ++i)
+            freePairs.insert(freePairs.end(), batch[i].output.pairs.begin(), batch[i].output.pairs.end());
+
+        {
+            MS_STATS_SCOPE(stats, StatsPhase::PairCost);
+            parallelForChunks(updated.size(), threadCount, [this, &updated](size_t, size_t begin, size_t end)
+                {
+                    PairCostBatch<Scalar> batch;
+                    setPairCosts({ updated.data() + begin, end - begin }, batch);
+                });
+        }
+
+        for (uint32_t pair : updated)
+            pushPair(pair);
+
+        if (progressCallback && !progressCallback(*this))
+            break;
+    }
+
+    compactFaces();
+}
+
+template<typename Index, typename Scalar>
+std::vector<uint32_t> BasicMeshSimplifier<Index, Scalar>::cluster(uint32_t resolution)
+{
+    MS_STATS_SCOPE(stats, StatsPhase::Clustering);
+    MS_TRACE_SCOPE("cluster");
+
+    compactFaces();
+
+    ClusterGrid grid(vertices, resolution);
+
+    std::vector<uint64_t> cells;
+    grid.getCells(vertices, locked, threadCount, cells);
+
+    // number the occupied cells in order of their first vertex, vertices removed by earlier collapses
+    // (or never used by a face) belong to no cluster
+    std::vector<uint32_t> clusterIds(vertices.size(), REMOVED_VERTEX);
+    std::vector<uint64_t> clusterCells;
+    std::unordered_map<uint64_t, uint32_t> cellClusters;
+    cellClusters.reserve(vertices.size() / 4);
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        if (vertexFaces[v].empty())
+            continue;
+
+        auto [it, inserted] = cellClusters.try_emplace(cells[v], (uint32_t)clusterCells.size());
+        if (inserted)
+            clusterCells.push_back(cells[v]);
+
+        clusterIds[v] = it->second;
+    }
+
+    size_t clusterCount = clusterCells.size();
+
+    // sum up the quadrics and positions of every cluster
+    std::vector<QuadricType> clusterErrors(clusterCount);
+    std::vector<glm::vec3> clusterCenters(clusterCount, glm::vec3(0.0f));
+    std::vector<uint32_t> clusterSizes(clusterCount, 0);
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        uint32_t c = clusterIds[v];
+        if (c == REMOVED_VERTEX)
+            continue;
+
+        clusterErrors[c] += errors[v];
+        clusterCenters[c] += vertices[v];
+        clusterSizes[c]++;
+    }
+
+    // place every cluster at the minimum of its quadric, the mean is used if there is no unique minimum in the cell.
+    // locked vertices are clusters of their own and keep their position.
+    std::vector<glm::vec3> clusterVertices(clusterCount);
+    parallelFor(clusterCount, threadCount, [&](size_t c)
+        {
+            clusterVertices[c] = clusterCenters[c] / (float)clusterSizes[c];
+            if (clusterCells[c] & ClusterGrid::LOCKED_CELL)
+                return;
+
+            // remove the identity every vertex quadric starts with, only the face planes are minimized
+            QuadricType q = clusterErrors[c] - QuadricType::diagonal((Scalar)clusterSizes[c]);
+
+            typename QuadricType::Vector x;
+            if (q.solve(x) && grid.getCell(glm::vec3(x)) == clusterCells[c])
+                clusterVertices[c] = glm::vec3(x);
+        });
+
+    // remap the faces and drop the ones that collapsed
+    size_t faceCount = 0;
+    for (size_t face = 0; face < getFaceCount(); ++face)
+    {
+        uint32_t c0 = clusterIds[indices[3 * face]];
+        uint32_t c1 = clusterIds[indices[3 * face + 1]];
+        uint32_t c2 = clusterIds[indices[3 * face + 2]];
+        if (c0 == c1 || c1 == c2 || c0 == c2)
+            continue;
+
+        indices[3 * faceCount] = (Index)c0;
+        indices[3 * faceCount + 1] = (Index)c1;
+        indices[3 * faceCount + 2] = (Index)c2;
+        faceIds[faceCount] = faceIds[face];
+        faceCount++;
+    }
+
+    MS_STATS_ADD(stats, facesRemoved, getFaceCount() - faceCount);
+
+    indices.resize(3 * faceCount);
+    faceIds.resize(faceCount);
+    vertices = std::move(clusterVertices);
+    errors = std::move(clusterErrors);
+
+    // clusters of locked vertices stay locked
+    std::vector<uint8_t> clusterLocked(clusterCount, 0);
+    for (size_t v = 0; v < clusterIds.size(); ++v)
+    {
+        if (locked[v] && clusterIds[v] != REMOVED_VERTEX)
+            clusterLocked[clusterIds[v]] = 1;
+    }
+    locked = std::move(clusterLocked);
+
+    // clusters can not be expressed as collapses
+    log.clear();
+
+    buildAdjacency();
+    buildPairs();
+
+    return clusterIds;
+}
+
+template<typename Index, typename Scalar>
+std::vector<uint32_t> BasicMeshSimplifier<Index, Scalar>::runClustered(size_t targetFaces)
+{
+    MS_TRACE_SCOPE("run clustered");
+
+    if (getFaceCount() <= targetFaces)
+        return { };
+
+    // leave some faces to the collapses, they pick much better ones than the grid
+    size_t clusterFaces = targetFaces + targetFaces / 8;
+
+    std::vector<uint64_t> cells;
+    auto countFaces = [this, &cells](uint32_t resolution)
+        {
+            ClusterGrid(vertices, resolution).getCells(vertices, locked, threadCount, cells);
+            return countClusteredFaces<Index>(indices, cells, threadCount);
+        };
+
+    // the face count of a surface grows with the square of the resolution, a few corrections get close
+    uint32_t resolution = 64;
+    size_t faces = countFaces(resolution);
+    for (int i = 0; i < 4 && faces > 0; ++i)
+    {
+        double scale = std::sqrt((double)clusterFaces / (double)faces);
+        resolution = (uint32_t)std::clamp(resolution * scale, 1.0, (double)ClusterGrid::MAX_RESOLUTION);
+        faces = countFaces(resolution);
+    }
+
+    // never cluster below the target
+    while (faces < targetFaces && resolution < ClusterGrid::MAX_RESOLUTION)
+    {
+        resolution = std::min(resolution + resolution / 4 + 1, ClusterGrid::MAX_RESOLUTION);
+        faces = countFaces(resolution);
+    }
+
+    if (progressCallback && !progressCallback(*this))
+        return { };
+
+    // clustering would not remove anything
+    std::vector<uint32_t> clusterIds;
+    if (faces < getFaceCount())
+        clusterIds = cluster(resolution);
+
+    if (progressCallback && !progressCallback(*this))
+        return clusterIds;
+
+    run(targetFaces);
+    return clusterIds;
+}
+
+template<typename Index, typename Scalar>
+LodChain BasicMeshSimplifier<Index, Scalar>::buildLods(std::span<const size_t> targetFaces)
+{
+    MS_TRACE_SCOPE("build lods");
+
+    std::vector<size_t> targets(targetFaces.begin(), targetFaces.end());
+    std::sort(targets.begin(), targets.end(), std::greater<size_t>());
+
+    // snapshot of a level: its indices and the positions of the referenced vertices at that time
+    struct Snapshot
+    {
+        std::vector<Index> indices;
+        std::vector<uint32_t> referenced;
+        std::vector<glm::vec3> positions;
+    };
+
+    std::vector<Snapshot> snapshots(targets.size());
+    std::vector<uint32_t> stamp(vertices.size(), UINT32_MAX);
+    for (uint32_t level = 0; level < targets.size(); ++level)
+    {
+        run(targets[level]);
+
+        Snapshot& snapshot = snapshots[level];
+        snapshot.indices = indices;
+        for (uint32_t index : indices)
+        {
+            if (stamp[index] == level) continue;
+
+            stamp[index] = level;
+            snapshot.referenced.push_back(index);
+            snapshot.positions.push_back(vertices[index]);
+        }
+    }
+
+    // build the shared vertex buffer from the coarsest to the finest level. a vertex only
+    // gets a new entry if it is new or was at a different position in the coarser level.
+    LodChain chain;
+    chain.levels.resize(targets.size());
+
+    std::vector<uint32_t> shared(vertices.size(), UINT32_MAX);
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<std::vector<uint32_t>> levelIndices(targets.size());
+    for (size_t level = targets.size(); level-- > 0; )
+    {
+        Snapshot& snapshot = snapshots[level];
+        for (size_t i = 0; i < snapshot.referenced.size(); ++i)
+        {
+            uint32_t vertex = snapshot.referenced[i];
+            glm::vec3 position = snapshot.positions[i];
+
+            if (shared[vertex] == UINT32_MAX || chain.vertices[shared[vertex]] != position)
+            {
+                shared[vertex] = (uint32_t)chain.vertices.size();
+                chain.vertices.push_back(position);
+            }
+            remap[vertex] = shared[vertex];
+        }
+
+        for (uint32_t index : snapshot.indices)
+            levelIndices[level].push_back(remap[index]);
+
+        chain.levels[level].vertexCount = chain.vertices.size();
+        snapshot = Snapshot();
+    }
+
+    // concatenate the index buffers from the finest to the coarsest level
+    for (size_t level = 0; level < targets.size(); ++level)
+    {
+        chain.levels[level].firstIndex = chain.indices.size();
+        chain.levels[level].indexCount = levelIndices[level].size();
+        chain.indices.insert(chain.indices.end(), levelIndices[level].begin(), levelIndices[level].end());
+    }
+
+    return chain;
+}
+
+template<typename Index, typename Scalar>
+LodChain BasicMeshSimplifier<Index, Scalar>::buildLodsByRatio(std::span<const float> ratios)
+{
+    std::vector<size_t> targets;
+    for (float ratio : ratios)
+        targets.push_back((size_t)(getFaceCount() * ratio));
+
+    return buildLods(targets);
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::buildAdjacency()
+{
+    MS_STATS_SCOPE(stats, StatsPhase::Errors);
+    MS_TRACE_SCOPE("adjacency");
+
+    vertexFaces.assign(vertices.size(), {});
+    for (uint32_t face = 0; face < getFaceCount(); ++face)
+    {
+        vertexFaces[indices[3 * face]].push_back(face);
+        vertexFaces[indices[3 * face + 1]].push_back(face);
+        vertexFaces[indices[3 * face + 2]].push_back(face);
+    }
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::createValidPairs()
+{
+    MS_STATS_SCOPE(stats, StatsPhase::Pairs);
+    MS_TRACE_SCOPE("create pairs");
+
+    // every edge in the mesh is a valid pair, each vertex collects the edges to its higher neighbours
+    std::vector<std::vector<VertexPair<Index>>> chunkPairs(getChunkCount(vertices.size(), threadCount));
+    parallelForChunks(vertices.size(), threadCount, [this, &chunkPairs](size_t chunk, size_t begin, size_t end)
+        {
+            std::vector<Index> neighbours;
+            for (uint32_t v = (uint32_t)begin; v < end; ++v)
+            {
+                neighbours.clear();
+                for (uint32_t face : vertexFaces[v])
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        if (indices[3 * face + i] > v)
+                            neighbours.push_back(indices[3 * face + i]);
+                    }
+                }
+
+                // remove duplicates
+                std::sort(neighbours.begin(), neighbours.end());
+                neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+                for (Index n : neighbours)
+                    chunkPairs[chunk].push_back({ (Index)v, n });
+            }
+        });
+
+    // concatenate the chunks and link the pairs to their vertices
+    pairs.clear();
+    vertexPairs.assign(vertices.size(), {});
+    for (auto& chunk : chunkPairs)
+    {
+        for (auto& p : chunk)
+        {
+            vertexPairs[p.first].push_back((uint32_t)pairs.size());
+            vertexPairs[p.second].push_back((uint32_t)pairs.size());
+            pairs.push_back(p);
+        }
+    }
+
+    removedPairCount = 0;
+    freePairs.clear();
+
+    if (pairDistance > 0.0f)
+        createDistancePairs();
+
+    pairCosts.resize(pairs.size());
+    pairPositions.resize(pairs.size());
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::createDistancePairs()
+{
+    MS_TRACE_SCOPE("distance pairs");
+
+    vertexGrid.distance = pairDistance;
+    vertexGrid.cellSize = 2.0f * pairDistance;
+    vertexGrid.vertexCells.resize(vertices.size());
+    parallelFor(vertices.size(), threadCount, [this](size_t v) { vertexGrid.vertexCells[v] = getGridCell(vertices[v], vertexGrid.cellSize); });
+
+    // only vertices with faces take part, unreferenced vertices would only be moved around
+    vertexGrid.cells.clear();
+    for (uint32_t v = 0; v < vertices.size(); ++v)
+    {
+        if (!vertexFaces[v].empty())
+            vertexGrid.cells[vertexGrid.vertexCells[v]].push_back(v);
+    }
+
+    // every vertex pairs with its higher neighbours in range that it has no edge with
+    std::vector<std::vector<VertexPair<Index>>> chunkPairs(getChunkCount(vertices.size(), threadCount));
+    parallelForChunks(vertices.size(), threadCount, [this, &chunkPairs](size_t chunk, size_t begin, size_t end)
+        {
+            for (uint32_t v = (uint32_t)begin; v < end; ++v)
+            {
+                if (vertexFaces[v].empty())
+                    continue;
+
+                forEachNearVertex(vertexGrid, vertices, v, [&](uint32_t other)
+                    {
+                        if (other > v && findPair(v, other) == INVALID_PAIR)
+                            chunkPairs[chunk].push_back({ (Index)v, (Index)other });
+                    });
+            }
+        });
+
+    for (auto& chunk : chunkPairs)
+    {
+        for (auto& p : chunk)
+            addPair(p.first, p.second);
+    }
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::updateDistancePairs(uint32_t newVertex, uint32_t removedVertex)
+{
+    removeFromGrid(vertexGrid, removedVertex);
+
+    uint64_t cell = getGridCell(vertices[newVertex], vertexGrid.cellSize);
+    if (cell != vertexGrid.vertexCells[newVertex] || vertexFaces[newVertex].empty())
+    {
+        removeFromGrid(vertexGrid, newVertex);
+        vertexGrid.vertexCells[newVertex] = cell;
+
+        // the vertex lost its last face
+        if (vertexFaces[newVertex].empty())
+            return;
+
+        vertexGrid.cells[cell].push_back(newVertex);
+    }
+
+    forEachNearVertex(vertexGrid, vertices, newVertex, [this, newVertex](uint32_t other)
+        {
+            if (!vertexFaces[other].empty() && findPair(newVertex, other) == INVALID_PAIR)
+                addPair(newVertex, other);
+        });
+}
+
+template<typename Index, typename Scalar>
+uint32_t BasicMeshSimplifier<Index, Scalar>::addPair(uint32_t v0, uint32_t v1)
+{
+    uint32_t pair;
+    if (!freePairs.empty())
+    {
+        // the version keeps counting, so the heap entries of the old pair stay stale
+        pair = freePairs.back();
+        freePairs.pop_back();
+
+        pairs[pair].first = (Index)v0;
+        pairs[pair].second = (Index)v1;
+        pairs[pair].removed = false;
+        removedPairCount--;
+    }
+    else
+    {
+        pair = (uint32_t)pairs.size();
+        pairs.push_back({ (Index)v0, (Index)v1 });
+        pairCosts.push_back(0.0f);
+        pairPositions.push_back(glm::vec3(0.0f));
+    }
+
+    vertexPairs[v0].push_back(pair);
+    vertexPairs[v1].push_back(pair);
+    return pair;
+}
+
+template<typename Index, typename Scalar>
+uint32_t BasicMeshSimplifier<Index, Scalar>::findPair(uint32_t v0, uint32_t v1) const
+{
+    for (uint32_t pair : vertexPairs[v0])
+    {
+        if (pairs[pair].first == v1 || pairs[pair].second == v1)
+            return pair;
+    }
+    return INVALID_PAIR;
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::setPairCosts(std::span<const uint32_t> ids, PairCostBatch<Scalar>& batch)
+{
+    size_t count = ids.size();
+    batch.first.resize(count);
+    batch.second.resize(count);
+    batch.positions.resize(count);
+    batch.costs.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        VertexPair<Index>& p = pairs[ids[i]];
+
+        // the first vertex is kept, so a locked vertex has to come first
+        if (locked[p.second] && !locked[p.first])
+            std::swap(p.first, p.second);
+
+        batch.first[i] = p.first;
+        batch.second[i] = p.second;
+        batch.positions[i] = locked[p.first] ? vertices[p.first] : (vertices[p.first] + vertices[p.second]) / 2.0f;
+    }
+
+    evaluatePairCosts(count, batch.first.data(), batch.second.data(), errors.data(), errors.size(), batch.positions.data(), batch.costs.data());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // pairs between two locked vertices never collapse
+        bool fixed = locked[batch.first[i]] && locked[batch.second[i]];
+
+        pairPositions[ids[i]] = batch.positions[i];
+        pairCosts[ids[i]] = fixed ? std::numeric_limits<Scalar>::infinity() : batch.costs[i];
+    }
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::updatePairs(std::span<const uint32_t> ids)
+{
+    {
+        MS_STATS_SCOPE(stats, StatsPhase::PairCost);
+        setPairCosts(ids, pairCostScratch);
+    }
+
+    for (uint32_t pair : ids)
+        pushPair(pair);
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::pushPair(uint32_t pair)
+{
+    VertexPair<Index>& p = pairs[pair];
+    p.version++;
+    MS_STATS_ADD(stats, pairsRecomputed, 1);
+
+    // too many stale entries, start over with a fresh heap
+    if (heap.size() >= 2 * getPairCount())
+    {
+        rebuildHeap();
+        return;
+    }
+
+    MS_STATS_SCOPE(stats, StatsPhase::Heap);
+    heap.push_back({ pairCosts[pair], pair, p.version });
+    std::push_heap(heap.begin(), heap.end(), HeapEntryComp());
+    MS_STATS_MAX(stats, peakHeapSize, heap.size());
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::rebuildHeap()
+{
+    MS_STATS_SCOPE(stats, StatsPhase::Heap);
+    MS_TRACE_SCOPE("rebuild heap");
+
+    heap.resize(pairs.size());
+    parallelFor(pairs.size(), threadCount, [this](size_t i)
+        {
+            heap[i] = { pairCosts[i], (uint32_t)i, pairs[i].version };
+        });
+
+    // drop the removed pairs
+    heap.erase(std::remove_if(heap.begin(), heap.end(), [this](const HeapEntry<Scalar>& e) { return pairs[e.pair].removed; }), heap.end());
+
+    std::make_heap(heap.begin(), heap.end(), HeapEntryComp());
+    MS_STATS_MAX(stats, peakHeapSize, heap.size());
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::calculateErrors()
+{
+    MS_STATS_SCOPE(stats, StatsPhase::Errors);
+    MS_TRACE_SCOPE("quadrics");
+
+    // the plane quadric of every face
+    std::vector<QuadricType> faceErrors(getFaceCount());
+    parallelForChunks(faceErrors.size(), threadCount, [this, &faceErrors](size_t, size_t begin, size_t end)
+        {
+            computePlaneQuadrics(vertices.data(), vertices.size(), indices.data(), begin, end - begin, faceErrors.data() + begin);
+        });
+
+    // every vertex sums up the quadrics of its faces (no two threads write the same vertex)
+    errors.resize(vertices.size());
+    parallelFor(vertices.size(), threadCount, [this, &faceErrors](size_t vertex)
+        {
+            QuadricType q = QuadricType::diagonal(Scalar(1));
+            for (uint32_t face : vertexFaces[vertex])
+                q += faceErrors[face];
+
+            errors[vertex] = q;
+        });
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::removeFaces(std::span<const uint32_t> faces)
+{
+    for (uint32_t face : faces)
+    {
+        Index* f = &indices[3 * face];
+        f[1] = f[2] = f[0];
+        faceIds[face] = REMOVED_FACE;
+    }
+
+    removedFaceCount += faces.size();
+    MS_STATS_ADD(stats, facesRemoved, faces.size());
+
+    // the compaction is paid for by the removals since the last one
+    if (removedFaceCount > getFaceCount())
+        compactFaces();
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::compactFaces()
+{
+    if (removedFaceCount == 0)
+        return;
+
+    MS_TRACE_SCOPE("compact faces");
+
+    std::vector<uint32_t> remap(faceIds.size());
+    uint32_t faceCount = 0;
+    for (size_t face = 0; face < faceIds.size(); ++face)
+    {
+        if (faceIds[face] == REMOVED_FACE)
+            continue;
+
+        remap[face] = faceCount;
+        std::copy_n(&indices[3 * face], 3, &indices[3 * faceCount]);
+        faceIds[faceCount] = faceIds[face];
+        faceCount++;
+    }
+
+    indices.resize(3 * faceCount);
+    faceIds.resize(faceCount);
+    removedFaceCount = 0;
+
+    parallelFor(vertexFaces.size(), threadCount, [this, &remap](size_t vertex)
+        {
+            for (uint32_t& face : vertexFaces[vertex])
+                face = remap[face];
+        });
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::compactPairs()
+{
+    MS_TRACE_SCOPE("compact pairs");
+
+    std::vector<uint32_t> remap(pairs.size(), INVALID_PAIR);
+    uint32_t pairCount = 0;
+    for (size_t pair = 0; pair < pairs.size(); ++pair)
+    {
+        if (pairs[pair].removed)
+            continue;
+
+        remap[pair] = pairCount;
+        pairs[pairCount] = pairs[pair];
+        pairCosts[pairCount] = pairCosts[pair];
+        pairPositions[pairCount] = pairPositions[pair];
+        pairCount++;
+    }
+
+    pairs.resize(pairCount);
+    pairCosts.resize(pairCount);
+    pairPositions.resize(pairCount);
+    removedPairCount = 0;
+    freePairs.clear();
+
+    parallelFor(vertexPairs.size(), threadCount, [this, &remap](size_t vertex)
+        {
+            for (uint32_t& pair : vertexPairs[vertex])
+                pair = remap[pair];
+        });
+
+    rebuildHeap();
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::collapseVertex(uint32_t newVertex, uint32_t removedVertex, CollapseOutput& output)
+{
+    // detach all faces containing both vertices and move the other faces to newVertex
+    std::vector<uint32_t>& faces = vertexFaces[removedVertex];
+    while (!faces.empty())
+    {
+        uint32_t face = faces.back();
+        Index* f = &indices[3 * face];
+
+        if (f[0] == newVertex || f[1] == newVertex || f[2] == newVertex)
+        {
+            for (int i = 0; i < 3; ++i)
+                eraseValue(vertexFaces[f[i]], face);
+
+            output.faces.push_back(face);
+            if (recording)
+                output.faceIds.push_back(faceIds[face]);
+
+            continue;
+        }
+
+        // replace one corner at a time (degenerate faces can contain removedVertex twice)
+        Index* corner = std::find(f, f + 3, removedVertex);
+        *corner = (Index)newVertex;
+
+        if (recording)
+            output.corners.push_back(3 * faceIds[face] + (uint32_t)(corner - f));
+
+        faces.pop_back();
+        vertexFaces[newVertex].push_back(face);
+    }
+
+    // move the pairs of removedVertex to newVertex (and remove duplicates)
+    for (uint32_t pair : vertexPairs[removedVertex])
+    {
+        VertexPair<Index>& p = pairs[pair];
+        uint32_t other = (p.first == removedVertex) ? p.second : p.first;
+
+        // the pair collapsed into a single vertex or already exists for newVertex
+        if (other == newVertex || findPair(newVertex, other) != INVALID_PAIR)
+        {
+            p.removed = true;
+            output.pairs.push_back(pair);
+            eraseValue(vertexPairs[other], pair);
+            continue;
+        }
+
+        if (p.first == removedVertex)
+            p.first = (Index)newVertex;
+        else
+            p.second = (Index)newVertex;
+
+        vertexPairs[newVertex].push_back(pair);
+    }
+    vertexPairs[removedVertex].clear();
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::removeVertex(uint32_t newVertex, uint32_t removedVertex)
+{
+    MS_STATS_SCOPE(stats, StatsPhase::RemoveVertex);
+
+    collapseScratch.clear();
+    collapseVertex(newVertex, removedVertex, collapseScratch);
+    removeFaces(collapseScratch.faces);
+    removedPairCount += collapseScratch.pairs.size();
+
+    if (pairDistance > 0.0f)
+        updateDistancePairs(newVertex, removedVertex);
+
+    // the slots are free once the new pairs were added (they can not take the pair being collapsed)
+    freePairs.insert(freePairs.end(), collapseScratch.pairs.begin(), collapseScratch.pairs.end());
+
+    if (recording)
+    {
+        log.faces.insert(log.faces.end(), collapseScratch.faceIds.begin(), collapseScratch.faceIds.end());
+        log.corners.insert(log.corners.end(), collapseScratch.corners.begin(), collapseScratch.corners.end());
+    }
+
+    MS_STATS_MAX(stats, peakVertexFaces, vertexFaces[newVertex].size());
+    MS_STATS_MAX(stats, peakVertexPairs, vertexPairs[newVertex].size());
+
+    // recalculate the cost of all pairs of the new vertex
+    updatePairs(vertexPairs[newVertex]);
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::gatherRing(uint32_t v0, uint32_t v1, std::vector<uint32_t>& ring) const
+{
+    ring.clear();
+    for (uint32_t v : { v0, v1 })
+    {
+        ring.push_back(v);
+
+        for (uint32_t face : vertexFaces[v])
+            ring.insert(ring.end(), &indices[3 * face], &indices[3 * face] + 3);
+
+        for (uint32_t pair : vertexPairs[v])
+            ring.push_back(pairs[pair].first == v ? pairs[pair].second : pairs[pair].first);
+    }
+}
+
+template<typename Index, typename Scalar>
+size_t BasicMeshSimplifier<Index, Scalar>::countSharedFaces(uint32_t v0, uint32_t v1) const
+{
+    size_t count = 0;
+    for (uint32_t face : vertexFaces[v1])
+    {
+        const Index* f = &indices[3 * face];
+        if (f[0] == v0 || f[1] == v0 || f[2] == v0)
+            count++;
+    }
+    return count;
+}
+
+
+template<typename Index, typename Scalar>
+size_t BasicMeshSimplifier<Index, Scalar>::getLiveVertexCount() const
+{
+    return std::count_if(vertexFaces.begin(), vertexFaces.end(), [](const std::vector<uint32_t>& faces) { return !faces.empty(); });
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::printPairs()
+{
+    printf("Pairs: (%zd)\n", pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        if (!pairs[i].removed)
+            printf(" - (%d, %d) error=%f\n", pairs[i].first, pairs[i].second, pairCosts[i]);
+    }
+}
+
+template<typename Index, typename Scalar>
+void BasicMeshSimplifier<Index, Scalar>::printFaces()
+{
+    printf("Faces: (%zd)\n", indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3)
+        printf("[%d, %d, %d]\n", indices[i], indices[i + 1], indices[i + 2]);
+}
@@ -0,0 +1,278 @@
+#include "ObjLoader.hpp"
+
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
+#include <charconv>
+#include <cstdio>
+
+// data of one chunk of the file, indices are global except for relative (negative) indices
+// which are stored relative to the first vertex of the chunk and fixed when merging
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<size_t> relative;
+
+    // "o" and "g" statements, firstFace is relative to the chunk
+    std::vector<MeshObject> objects;
+};
+
+static const char* skipSpaces(const char* c, const char* end)
+{
+    while (c < end && (*c == ' ' || *c == '\t')) ++c;
+    return c;
+}
+
+static const char* skipLine(const char* c, const char* end)
+{
+    while (c < end && *c != '\n') ++c;
+    return c < end ? c + 1 : end;
+}
+
+static const char* parseFloat(const char* c, const char* end, float& value)
+{
+    c = skipSpaces(c, end);
+    if (c < end && *c == '+') ++c;
+
+    auto result = std::from_chars(c, end, value);
+    if (result.ec != std::errc()) value = 0.0f;
+
+    return result.ptr;
+}
+
+static void parseChunk(ObjChunk& chunk)
+{
+    std::vector<uint32_t> face;
+    std::vector<bool> faceRelative;
+
+    const char* end = chunk.end;
+    for (const char* c = skipSpaces(chunk.begin, end); c < end; c = skipSpaces(skipLine(c, end), end))
+    {
+        if (end - c < 2 || (c[1] != ' ' && c[1] != '\t'))
+            continue;
+
+        if (c[0] == 'o' || c[0] == 'g') // object or group
+        {
+            const char* name = skipSpaces(c + 1, end);
+            const char* nameEnd = name;
+            while (nameEnd < end && *nameEnd != '\n' && *nameEnd != '\r') ++nameEnd;
+            while (nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) --nameEnd;
+
+            chunk.objects.push_back({ std::string(name, nameEnd), (uint32_t)(chunk.indices.size() / 3), 0 });
+        }
+        else if (c[0] == 'v') // vertex position
+        {
+            glm::vec3 v;
+            c = parseFloat(c + 1, end, v.x);
+            c = parseFloat(c, end, v.y);
+            c = parseFloat(c, end, v.z);
+            chunk.vertices.push_back(v);
+        }
+        else if (c[0] == 'f') // face
+        {
+            face.clear();
+            faceRelative.clear();
+
+            c = skipSpaces(c + 1, end);
+            while (c < end && *c != '\n' && *c != '\r')
+            {
+                // only the position index of "v/vt/vn" is used
+                int64_t index = 0;
+                auto result = std::from_chars(c, end, index);
+                c = result.ptr;
+                while (c < end && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r') ++c;
+                c = skipSpaces(c, end);
+
+                if (result.ec != std::errc() || index == 0)
+                    continue;
+
+                if (index > 0)
+                {
+                    face.push_back((uint32_t)(index - 1));
+                    faceRelative.push_back(false);
+                }
+                else
+                {
+                    // relative to the vertices read so far, wraps around until the chunk offset is added
+                    face.push_back((uint32_t)((int64_t)chunk.vertices.size() + index));
+                    faceRelative.push_back(true);
+                }
+            }
+
+            // create triangle faces
+            for (size_t i = 2; i < face.size(); ++i)
+            {
+                size_t corners[] = { 0, i - 1, i };
+                for (size_t corner : corners)
+                {
+                    if (faceRelative[corner])
+                        chunk.relative.push_back(chunk.indices.size());
+                    chunk.indices.push_back(face[corner]);
+                }
+            }
+        }
+    }
+}
+
+bool loadObj(const std::string& filename, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, size_t threadCount,
+    std::vector<MeshObject>* objects)
+{
+    vertices.clear();
+    indices.clear();
+    if (objects)
+        objects->clear();
+
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        printf("Failed to open OBJ model \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    const char* data = file.getData();
+    size_t size = file.getSize();
+
+    // split the file into chunks that start at the beginning of a line
+    const size_t minChunkSize = 1 << 20;
+    size_t chunkCount = std::min(resolveThreadCount(threadCount), size / minChunkSize + 1);
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* begin = data;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* end = data + size * (i + 1) / chunkCount;
+        if (i + 1 < chunkCount)
+            end = skipLine(std::max(begin, end - 1), data + size);
+
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+
+    parallelFor(chunkCount, chunkCount, [&chunks](size_t i) { parseChunk(chunks[i]); });
+
+    // offsets of the chunks in the merged arrays
+    std::vector<size_t> vertexOffsets(chunkCount + 1, 0);
+    std::vector<size_t> indexOffsets(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        vertexOffsets[i + 1] = vertexOffsets[i] + chunks[i].vertices.size();
+        indexOffsets[i + 1] = indexOffsets[i] + chunks[i].indices.size();
+    }
+
+    vertices.resize(vertexOffsets[chunkCount]);
+    indices.resize(indexOffsets[chunkCount]);
+
+    parallelFor(chunkCount, chunkCount, [&](size_t i)
+        {
+            ObjChunk& chunk = chunks[i];
+            for (size_t r : chunk.relative)
+                chunk.indices[r] += (uint32_t)vertexOffsets[i];
+
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + vertexOffsets[i]);
+            std::copy(chunk.indices.begin(), chunk.indices.end(), indices.begin() + indexOffsets[i]);
+
+            // free the chunk early to keep the peak memory low
+            chunk.vertices = {};
+            chunk.indices = {};
+        });
+
+    // start of every object in the merged faces
+    std::vector<MeshObject> starts;
+    if (objects)
+    {
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            for (auto& object : chunks[i].objects)
+                starts.push_back({ std::move(object.name), object.firstFace + (uint32_t)(indexOffsets[i] / 3), 0 });
+        }
+
+        // faces before the first statement
+        if (!starts.empty() && starts[0].firstFace > 0)
+            starts.insert(starts.begin(), { "", 0, 0 });
+    }
+
+    // remove faces that reference vertices that do not exist (moving the object starts along)
+    uint32_t vertexCount = (uint32_t)vertices.size();
+    size_t faceCount = indices.size() / 3;
+    size_t validFaces = 0;
+    size_t nextStart = 0;
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        for (; nextStart < starts.size() && starts[nextStart].firstFace == i; ++nextStart)
+            starts[nextStart].firstFace = (uint32_t)validFaces;
+
+        if (indices[3 * i] >= vertexCount || indices[3 * i + 1] >= vertexCount || indices[3 * i + 2] >= vertexCount)
+            continue;
+
+        if (validFaces != i)
+            std::copy_n(indices.begin() + 3 * i, 3, indices.begin() + 3 * validFaces);
+        validFaces++;
+    }
+
+    if (validFaces != faceCount)
+    {
+        printf("Skipped %zd faces with invalid indices in \"%s\".\n", faceCount - validFaces, filename.c_str());
+        indices.resize(3 * validFaces);
+    }
+
+    // objects end where the next one starts, empty ones (e.g. "o" directly followed by "g") are dropped
+    for (; nextStart < starts.size(); ++nextStart)
+        starts[nextStart].firstFace = (uint32_t)validFaces;
+
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+        uint32_t end = i + 1 < starts.size() ? starts[i + 1].firstFace : (uint32_t)validFaces;
+        starts[i].faceCount = end - starts[i].firstFace;
+        if (starts[i].faceCount > 0)
+            objects->push_back(std::move(starts[i]));
+    }
+
+    return true;
+}
+
+bool streamObj(const std::string& filename, const std::function<void(const glm::vec3&)>& onVertex,
+    const std::function<void(uint32_t, uint32_t, uint32_t)>& onTriangle, size_t blockSize)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        printf("Failed to open OBJ model \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    const char* data = file.getData();
+    const char* end = data + file.getSize();
+
+    // parse the file block by block, each block starts at the beginning of a line
+    size_t vertexOffset = 0;
+    ObjChunk chunk;
+    for (const char* begin = data; begin < end; begin = chunk.end)
+    {
+        chunk.begin = begin;
+        chunk.end = (size_t)(end - begin) > blockSize ? skipLine(begin + blockSize - 1, end) : end;
+        chunk.vertices.clear();
+        chunk.indices.clear();
+        chunk.relative.clear();
+        chunk.objects.clear();
+
+        parseChunk(chunk);
+
+        for (size_t r : chunk.relative)
+            chunk.indices[r] += (uint32_t)vertexOffset;
+
+        for (auto& v : chunk.vertices)
+            onVertex(v);
+
+        for (size_t i = 0; i + 2 < chunk.indices.size(); i += 3)
+            onTriangle(chunk.indices[i], chunk.indices[i + 1], chunk.indices[i + 2]);
+
+        vertexOffset += chunk.vertices.size();
+    }
+
+    return true;
+}
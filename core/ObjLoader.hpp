@@ -0,0 +1,23 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshObject.hpp"
+
+// load the vertex positions and faces of an .obj file (polygons are triangulated as fans).
+// the file is memory mapped and parsed in newline aligned chunks using up to threadCount threads
+// (0 uses all hardware threads). if objects is given it receives the face ranges of the "o" and
+// "g" statements (empty if there are none, faces before the first one form an unnamed object).
+// returns false if the file could not be opened.
+bool loadObj(const std::string& filename, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, size_t threadCount = 0,
+    std::vector<MeshObject>* objects = nullptr);
+
+// read an .obj file in blocks of about blockSize bytes without keeping the mesh in memory.
+// onVertex is called for every position and onTriangle for every triangle (fan triangulated,
+// 0 based indices). indices are not validated, they can refer to vertices that do not exist.
+bool streamObj(const std::string& filename, const std::function<void(const glm::vec3&)>& onVertex,
+    const std::function<void(uint32_t, uint32_t, uint32_t)>& onTriangle, size_t blockSize = 16 << 20);
@@ -0,0 +1,220 @@
+#include "ObjWriter.hpp"
+
+#include "MeshCache.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <vector>
+
+// lines formatted by one thread at a time, all buffers of a round are written before the next one
+constexpr size_t LINES_PER_CHUNK = 1 << 16;
+
+// upper bounds of the lines (shortest round trip floats have at most 15 characters, indices 10 digits)
+constexpr size_t MAX_FLOAT_LENGTH = 16;
+constexpr size_t MAX_INDEX_LENGTH = 10;
+constexpr size_t MAX_VERTEX_LINE = 2 + 3 * MAX_FLOAT_LENGTH + 3;
+constexpr size_t MAX_FACE_LINE = 2 + 3 * MAX_INDEX_LENGTH + 3;
+
+constexpr uint32_t UNUSED_VERTEX = UINT32_MAX;
+
+// number the referenced vertices in the order of their first use
+template<typename Index>
+static void numberVertices(size_t vertexCount, std::span<const Index> indices, std::vector<uint32_t>& remap, std::vector<uint32_t>& order)
+{
+    remap.assign(vertexCount, UNUSED_VERTEX);
+    order.clear();
+    for (uint32_t index : indices)
+    {
+        if (remap[index] != UNUSED_VERTEX) continue;
+
+        remap[index] = (uint32_t)order.size();
+        order.push_back(index);
+    }
+}
+
+static char* formatFloat(char* out, float value)
+{
+    return std::to_chars(out, out + MAX_FLOAT_LENGTH, value).ptr;
+}
+
+static char* formatIndex(char* out, uint32_t value)
+{
+    return std::to_chars(out, out + MAX_INDEX_LENGTH, value).ptr;
+}
+
+// format the lines [0, lineCount) in chunks, one chunk per buffer and thread, and write them in order.
+// format(begin, end, buffer) replaces the buffer with the lines [begin, end).
+template<typename Format>
+static bool writeLines(FILE* file, size_t lineCount, std::vector<std::vector<char>>& buffers, Format format)
+{
+    size_t chunkCount = (lineCount + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+    for (size_t first = 0; first < chunkCount; first += buffers.size())
+    {
+        size_t count = std::min(buffers.size(), chunkCount - first);
+        parallelFor(count, count, [&](size_t i)
+            {
+                size_t begin = (first + i) * LINES_PER_CHUNK;
+                format(begin, std::min(lineCount, begin + LINES_PER_CHUNK), buffers[i]);
+            });
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (fwrite(buffers[i].data(), 1, buffers[i].size(), file) != buffers[i].size())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename Index>
+static bool writeObjIndices(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const Index> indices,
+    std::span<const MeshObject> objects, size_t threadCount)
+{
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        printf("Failed to open \"%s\" for writing.\n", filename.c_str());
+        return false;
+    }
+
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> order;
+    numberVertices(vertices.size(), indices, remap, order);
+
+    // objects that get an "o" line, in the order of their faces
+    std::vector<const MeshObject*> starts;
+    for (auto& object : objects)
+    {
+        if (!object.name.empty() && object.faceCount > 0)
+            starts.push_back(&object);
+    }
+    std::stable_sort(starts.begin(), starts.end(), [](const MeshObject* a, const MeshObject* b) { return a->firstFace < b->firstFace; });
+
+    std::vector<std::vector<char>> buffers(resolveThreadCount(threadCount));
+
+    bool success = writeLines(file, order.size(), buffers, [&](size_t begin, size_t end, std::vector<char>& buffer)
+        {
+            buffer.resize((end - begin) * MAX_VERTEX_LINE);
+            char* out = buffer.data();
+            for (size_t i = begin; i < end; ++i)
+            {
+                const glm::vec3& vertex = vertices[order[i]];
+                *out++ = 'v';
+                *out++ = ' ';
+                out = formatFloat(out, vertex.x);
+                *out++ = ' ';
+                out = formatFloat(out, vertex.y);
+                *out++ = ' ';
+                out = formatFloat(out, vertex.z);
+                *out++ = '\n';
+            }
+            buffer.resize(out - buffer.data());
+        });
+
+    success = success && writeLines(file, indices.size() / 3, buffers, [&](size_t begin, size_t end, std::vector<char>& buffer)
+        {
+            auto byFace = [](const MeshObject* object, size_t face) { return object->firstFace < face; };
+            auto start = std::lower_bound(starts.begin(), starts.end(), begin, byFace);
+            auto last = std::lower_bound(start, starts.end(), end, byFace);
+
+            size_t size = (end - begin) * MAX_FACE_LINE;
+            for (auto it = start; it != last; ++it)
+                size += 3 + (*it)->name.size();
+
+            buffer.resize(size);
+            char* out = buffer.data();
+            for (size_t face = begin; face < end; ++face)
+            {
+                for (; start != last && (*start)->firstFace <= face; ++start)
+                {
+                    *out++ = 'o';
+                    *out++ = ' ';
+                    out = std::copy((*start)->name.begin(), (*start)->name.end(), out);
+                    *out++ = '\n';
+                }
+
+                *out++ = 'f';
+                *out++ = ' ';
+                out = formatIndex(out, remap[indices[3 * face]] + 1);
+                *out++ = ' ';
+                out = formatIndex(out, remap[indices[3 * face + 1]] + 1);
+                *out++ = ' ';
+                out = formatIndex(out, remap[indices[3 * face + 2]] + 1);
+                *out++ = '\n';
+            }
+            buffer.resize(out - buffer.data());
+        });
+
+    success = (fclose(file) == 0) && success;
+    if (!success)
+    {
+        printf("Failed to write \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+template<typename Index>
+static bool writeMeshBinaryIndices(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const Index> indices,
+    std::span<const MeshObject> objects)
+{
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> order;
+    numberVertices(vertices.size(), indices, remap, order);
+
+    std::vector<glm::vec3> compactVertices(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        compactVertices[i] = vertices[order[i]];
+
+    std::vector<uint32_t> compactIndices(indices.size() / 3 * 3);
+    for (size_t i = 0; i < compactIndices.size(); ++i)
+        compactIndices[i] = remap[indices[i]];
+
+    return writeMeshCache(filename, compactVertices, compactIndices, {}, objects);
+}
+
+bool writeObj(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects, size_t threadCount)
+{
+    return writeObjIndices(filename, vertices, indices, objects, threadCount);
+}
+
+bool writeObj(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects, size_t threadCount)
+{
+    return writeObjIndices(filename, vertices, indices, objects, threadCount);
+}
+
+bool writeMeshBinary(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects)
+{
+    return writeMeshBinaryIndices(filename, vertices, indices, objects);
+}
+
+bool writeMeshBinary(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects)
+{
+    return writeMeshBinaryIndices(filename, vertices, indices, objects);
+}
+
+bool writeMesh(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects, size_t threadCount)
+{
+    if (filename.ends_with(MESH_CACHE_EXTENSION))
+        return writeMeshBinary(filename, vertices, indices, objects);
+
+    return writeObj(filename, vertices, indices, objects, threadCount);
+}
+
+bool writeMesh(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects, size_t threadCount)
+{
+    if (filename.ends_with(MESH_CACHE_EXTENSION))
+        return writeMeshBinary(filename, vertices, indices, objects);
+
+    return writeObj(filename, vertices, indices, objects, threadCount);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "MeshObject.hpp"
+
+// write the mesh as an .obj file, vertices that are not referenced by any face are skipped and
+// every named object starts with an "o" line before its faces. the lines are formatted with
+// std::to_chars in chunks on threadCount threads (0 uses all hardware threads) and written in
+// large blocks, so the memory used does not grow with the mesh. returns false if the file could not be written.
+bool writeObj(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects = {}, size_t threadCount = 0);
+bool writeObj(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects = {}, size_t threadCount = 0);
+
+// write the referenced vertices, the faces and the objects as a binary mesh cache (.msb) that
+// MeshData maps without parsing (always with 32 bit indices). returns false if the file could not be written.
+bool writeMeshBinary(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects = {});
+bool writeMeshBinary(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects = {});
+
+// binary for files ending in MESH_CACHE_EXTENSION, .obj otherwise
+bool writeMesh(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects = {}, size_t threadCount = 0);
+bool writeMesh(const std::string& filename, std::span<const glm::vec3> vertices, std::span<const uint16_t> indices,
+    std::span<const MeshObject> objects = {}, size_t threadCount = 0);
@@ -0,0 +1,268 @@
+#include "ObjectSimplifier.hpp"
+
+#include "Instrumentation.hpp"
+#include "JobSystem.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+constexpr uint32_t NO_OBJECT = UINT32_MAX;
+constexpr uint32_t SHARED_VERTEX = UINT32_MAX - 1;
+
+// one object with its own vertex numbering
+struct ObjectPart
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> globalIds;    // input vertex of every local vertex (sorted until clustered)
+    std::vector<uint8_t> locked;        // vertices shared with other objects
+    size_t targetFaces = 0;
+
+    // error budgets: the simplified sequence, the highest cost so far and the face count after every collapse
+    ProgressiveMesh progressive;
+    std::vector<float> thresholds;
+    std::vector<size_t> faceCounts;
+
+    // simplified mesh with local vertex ids
+    std::vector<glm::vec3> outputVertices;
+    std::vector<uint32_t> outputIndices;
+};
+
+// copy the faces of the object, the local vertices keep the order of the input
+static void extractPart(const MeshObject& object, std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    const std::vector<uint32_t>& owners, ObjectPart& part)
+{
+    std::span<const uint32_t> objectIndices = indices.subspan(3 * (size_t)object.firstFace, 3 * (size_t)object.faceCount);
+
+    part.globalIds.assign(objectIndices.begin(), objectIndices.end());
+    std::sort(part.globalIds.begin(), part.globalIds.end());
+    part.globalIds.erase(std::unique(part.globalIds.begin(), part.globalIds.end()), part.globalIds.end());
+
+    part.vertices.resize(part.globalIds.size());
+    part.locked.resize(part.globalIds.size());
+    for (size_t v = 0; v < part.globalIds.size(); ++v)
+    {
+        part.vertices[v] = vertices[part.globalIds[v]];
+        part.locked[v] = owners[part.globalIds[v]] == SHARED_VERTEX;
+    }
+
+    part.indices.resize(objectIndices.size());
+    for (size_t i = 0; i < objectIndices.size(); ++i)
+        part.indices[i] = (uint32_t)(std::lower_bound(part.globalIds.begin(), part.globalIds.end(), objectIndices[i]) - part.globalIds.begin());
+}
+
+// clustering renumbers the local vertices, every cluster takes the input vertex of one of its members.
+// locked vertices are clusters of their own, so the shared vertices keep their input vertex.
+static void remapClusters(ObjectPart& part, std::span<const uint32_t> clusterIds, size_t clusterCount)
+{
+    std::vector<uint32_t> globalIds(clusterCount);
+    for (size_t v = 0; v < clusterIds.size(); ++v)
+    {
+        if (clusterIds[v] != MeshSimplifier::REMOVED_VERTEX)
+            globalIds[clusterIds[v]] = part.globalIds[v];
+    }
+    part.globalIds = std::move(globalIds);
+}
+
+// the cheapest collapses over all objects until the target is reached, every object gets the
+// face count after its last accepted collapse
+static void distributeByError(std::vector<ObjectPart>& parts, std::span<const MeshObject> objects, size_t targetFaces)
+{
+    struct Step
+    {
+        float threshold;
+        uint32_t part;
+        uint32_t collapse;
+    };
+
+    std::vector<Step> steps;
+    size_t faces = 0;
+    for (uint32_t p = 0; p < parts.size(); ++p)
+    {
+        faces += objects[p].faceCount;
+        for (uint32_t c = 0; c < parts[p].thresholds.size(); ++c)
+            steps.push_back({ parts[p].thresholds[c], p, c });
+    }
+
+    // the thresholds of an object never decrease, so every object applies a prefix of its collapses
+    std::sort(steps.begin(), steps.end(), [](const Step& a, const Step& b)
+        {
+            if (a.threshold != b.threshold) return a.threshold < b.threshold;
+            if (a.part != b.part) return a.part < b.part;
+            return a.collapse < b.collapse;
+        });
+
+    for (uint32_t p = 0; p < parts.size(); ++p)
+        parts[p].targetFaces = objects[p].faceCount;
+
+    for (const Step& step : steps)
+    {
+        if (faces <= targetFaces)
+            break;
+
+        ObjectPart& part = parts[step.part];
+        size_t after = part.faceCounts[step.collapse];
+        faces -= part.targetFaces - after;
+        part.targetFaces = after;
+    }
+}
+
+ObjectMesh simplifyObjects(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects, const ObjectOptions& options)
+{
+    MS_TRACE_SCOPE("simplify objects");
+
+    std::vector<MeshObject> wholeMesh;
+    if (objects.empty())
+    {
+        wholeMesh.push_back({ "", 0, (uint32_t)(indices.size() / 3) });
+        objects = wholeMesh;
+    }
+
+    // vertices used by more than one object are locked, so the objects stay connected
+    std::vector<uint32_t> owners(vertices.size(), NO_OBJECT);
+    size_t totalFaces = 0;
+    for (uint32_t o = 0; o < objects.size(); ++o)
+    {
+        for (size_t i = 3 * (size_t)objects[o].firstFace; i < 3 * ((size_t)objects[o].firstFace + objects[o].faceCount); ++i)
+        {
+            uint32_t& owner = owners[indices[i]];
+            owner = (owner == NO_OBJECT || owner == o) ? o : SHARED_VERTEX;
+        }
+        totalFaces += objects[o].faceCount;
+    }
+
+    size_t targetFaces = options.targetFaces > 0 ? options.targetFaces : (size_t)(totalFaces * options.ratio);
+    bool byError = options.budget == FaceBudget::Error;
+
+    std::vector<ObjectPart> parts(objects.size());
+    for (size_t o = 0; o < objects.size(); ++o)
+        parts[o].targetFaces = totalFaces > 0 ? (size_t)((double)targetFaces * objects[o].faceCount / totalFaces + 0.5) : 0;
+
+    // largest objects first, the small ones fill the gaps at the end
+    std::vector<uint32_t> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&objects](uint32_t a, uint32_t b) { return objects[a].faceCount > objects[b].faceCount; });
+
+    JobSystem jobs(options.threadCount);
+
+    // an object with more than an even share of the faces can not be balanced by the order alone,
+    // its collapses run in parallel batches whose jobs idle threads steal as well.
+    // a single object (e.g. a file without groups) collapses serially like the whole mesh would.
+    size_t evenShare = jobs.getThreadCount() > 1 && objects.size() > 1 ? totalFaces / jobs.getThreadCount() : totalFaces;
+
+    JobCounter counter;
+    for (uint32_t o : order)
+    {
+        jobs.submit(counter, [&, o]()
+            {
+                MS_TRACE_SCOPE("object");
+
+                ObjectPart& part = parts[o];
+                bool parallel = options.parallel || objects[o].faceCount > evenShare;
+                extractPart(objects[o], vertices, indices, owners, part);
+
+                // small objects get 16 bit indices, the setup of large objects is split into jobs of the same system
+                visitMeshSimplifier(part.vertices.size(), options.precision, [&](auto& simplifier)
+                    {
+                        simplifier.setThreadCount(jobs.getThreadCount());
+                        simplifier.setPairDistance(options.pairDistance);
+                        simplifier.setLockedVertices(std::move(part.locked));
+
+                        if (!byError)
+                        {
+                            simplifier.setup(std::move(part.vertices), std::move(part.indices));
+                            if (options.cluster)
+                            {
+                                std::vector<uint32_t> clusterIds = simplifier.runClustered(part.targetFaces);
+                                if (!clusterIds.empty())
+                                    remapClusters(part, clusterIds, simplifier.getVertices().size());
+                            }
+                            else if (parallel)
+                                simplifier.runParallel(part.targetFaces);
+                            else
+                                simplifier.run(part.targetFaces);
+
+                            part.outputVertices.assign(simplifier.getVertices().begin(), simplifier.getVertices().end());
+                            part.outputIndices.assign(simplifier.getIndices().begin(), simplifier.getIndices().end());
+                            return;
+                        }
+
+                        // record the whole sequence, the level is picked once all objects are done
+                        simplifier.setRecording(true);
+                        simplifier.setup(part.vertices, part.indices);
+                        if (parallel)
+                            simplifier.runParallel(0);
+                        else
+                            simplifier.run(0);
+
+                        const CollapseLog& log = simplifier.getCollapseLog();
+                        size_t faces = objects[o].faceCount;
+                        float threshold = 0.0f;
+                        for (auto& record : log.collapses)
+                        {
+                            threshold = std::max(threshold, record.cost);
+                            faces -= record.faceCount;
+                            part.thresholds.push_back(threshold);
+                            part.faceCounts.push_back(faces);
+                        }
+
+                        part.progressive = ProgressiveMesh(part.vertices, part.indices, log);
+                        part.vertices = { };
+                        part.indices = { };
+                    });
+            });
+    }
+    jobs.wait(counter);
+
+    if (byError)
+    {
+        distributeByError(parts, objects, targetFaces);
+
+        for (uint32_t o : order)
+        {
+            jobs.submit(counter, [&, o]()
+                {
+                    ObjectPart& part = parts[o];
+                    part.progressive.setFaceCount(part.targetFaces);
+                    part.outputVertices.assign(part.progressive.getVertices().begin(), part.progressive.getVertices().end());
+                    part.outputIndices.assign(part.progressive.getIndices().begin(), part.progressive.getIndices().end());
+                    part.progressive = ProgressiveMesh();
+                });
+        }
+        jobs.wait(counter);
+    }
+
+    // concatenate the objects, shared vertices get one output vertex
+    MS_TRACE_SCOPE("merge objects");
+
+    ObjectMesh result;
+    std::vector<uint32_t> sharedOutput(vertices.size(), UINT32_MAX);
+    std::vector<uint32_t> localOutput;
+    for (size_t o = 0; o < objects.size(); ++o)
+    {
+        ObjectPart& part = parts[o];
+        result.objects.push_back({ objects[o].name, (uint32_t)(result.indices.size() / 3), (uint32_t)(part.outputIndices.size() / 3) });
+
+        localOutput.assign(part.outputVertices.size(), UINT32_MAX);
+        for (uint32_t index : part.outputIndices)
+        {
+            uint32_t* output = &localOutput[index];
+            if (owners[part.globalIds[index]] == SHARED_VERTEX)
+                output = &sharedOutput[part.globalIds[index]];
+
+            if (*output == UINT32_MAX)
+            {
+                *output = (uint32_t)result.vertices.size();
+                result.vertices.push_back(part.outputVertices[index]);
+            }
+
+            result.indices.push_back(*output);
+        }
+
+        part = ObjectPart();
+    }
+
+    return result;
+}
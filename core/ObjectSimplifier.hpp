@@ -0,0 +1,47 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshObject.hpp"
+#include "Quadric.hpp"
+
+// how the face budget is split between the objects
+enum class FaceBudget
+{
+    Proportional,   // every object keeps the same fraction of its faces
+    Error           // all objects stop at about the same collapse cost (detailed objects keep more faces)
+};
+
+struct ObjectOptions
+{
+    float ratio = 0.5f;         // target face count relative to the input
+    size_t targetFaces = 0;     // target face count of all objects together (overrides ratio)
+    FaceBudget budget = FaceBudget::Proportional;
+    QuadricPrecision precision = QuadricPrecision::Float;
+    size_t threadCount = 0;     // threads of the job system (0 uses all hardware threads)
+
+    float pairDistance = 0.0f;  // also pair vertices of an object closer than this that share no edge
+    bool parallel = false;      // collapse batches of independent pairs concurrently (always for dominant objects)
+    bool cluster = false;       // vertex clustering before the collapses (not with error budgets)
+};
+
+// simplified objects in one buffer. vertices used by several objects are locked and stay shared.
+struct ObjectMesh
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshObject> objects;
+};
+
+// simplify every object with its own simplifier, concurrently on a work stealing job system.
+// the largest objects start first and split their setup into jobs that idle threads steal. objects
+// with more than an even share of the faces per thread also collapse in parallel batches (like
+// runParallel), so one dominant object among small ones uses the whole pool. without objects the mesh
+// is one object, a single object collapses serially unless options.parallel is set.
+// error budgets run every object to the end once to find the common cost threshold.
+// every object gets the simplifier with the narrowest indices that fit its vertex count.
+ObjectMesh simplifyObjects(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices,
+    std::span<const MeshObject> objects, const ObjectOptions& options);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.hpp"
+
+// resolve the number of threads to use (0 means one thread per hardware thread)
+inline size_t resolveThreadCount(size_t threadCount)
+{
+    if (threadCount > 0) return threadCount;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// split [0, count) into contiguous chunks and call func(chunk, begin, end) for every chunk.
+// the calling thread works on the first chunk, so threadCount == 1 runs without spawning threads.
+// inside a job of a JobSystem the other chunks are queued as jobs that idle threads can steal.
+template<typename Func>
+void parallelForChunks(size_t count, size_t threadCount, Func func)
+{
+    size_t chunks = std::min(resolveThreadCount(threadCount), count);
+    if (chunks <= 1)
+    {
+        if (count > 0) func(0, 0, count);
+        return;
+    }
+
+    size_t chunkSize = (count + chunks - 1) / chunks;
+
+    if (JobSystem* jobs = JobSystem::current())
+    {
+        JobCounter counter;
+        for (size_t chunk = 1; chunk < chunks; ++chunk)
+        {
+            size_t begin = std::min(count, chunk * chunkSize);
+            size_t end = std::min(count, begin + chunkSize);
+            jobs->submit(counter, [=, &func]() { func(chunk, begin, end); });
+        }
+
+        func(0, 0, std::min(count, chunkSize));
+        jobs->wait(counter);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for (size_t chunk = 1; chunk < chunks; ++chunk)
+    {
+        size_t begin = std::min(count, chunk * chunkSize);
+        size_t end = std::min(count, begin + chunkSize);
+        threads.emplace_back([=, &func]() { func(chunk, begin, end); });
+    }
+
+    func(0, 0, std::min(count, chunkSize));
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+// number of chunks parallelForChunks will use for the given count
+inline size_t getChunkCount(size_t count, size_t threadCount)
+{
+    return std::max<size_t>(1, std::min(resolveThreadCount(threadCount), count));
+}
+
+// call func(i) for every i in [0, count) using up to threadCount threads
+template<typename Func>
+void parallelFor(size_t count, size_t threadCount, Func func)
+{
+    parallelForChunks(count, threadCount, [&func](size_t, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                func(i);
+        });
+}
@@ -0,0 +1,89 @@
+#include "ProgressiveMesh.hpp"
+
+#include <algorithm>
+
+ProgressiveMesh::ProgressiveMesh(std::span<const glm::vec3> v, std::span<const uint32_t> i, const CollapseLog& log)
+    : vertices(v.begin(), v.end()), collapses(log.collapses)
+{
+    size_t inputFaces = i.size() / 3;
+
+    // collapse that removes each face (faces that are never removed keep the collapse count)
+    std::vector<uint32_t> removedAt(inputFaces, (uint32_t)collapses.size());
+    for (uint32_t c = 0; c < collapses.size(); ++c)
+    {
+        const CollapseRecord& record = collapses[c];
+        for (uint32_t f = 0; f < record.faceCount; ++f)
+            removedAt[log.faces[record.firstFace + f]] = c;
+    }
+
+    // order the faces so that faces removed later come first
+    std::vector<uint32_t> order(inputFaces);
+    for (uint32_t f = 0; f < inputFaces; ++f)
+        order[f] = f;
+
+    std::stable_sort(order.begin(), order.end(), [&removedAt](uint32_t a, uint32_t b) { return removedAt[a] > removedAt[b]; });
+
+    std::vector<uint32_t> position(inputFaces);
+    indices.resize(3 * inputFaces);
+    for (uint32_t f = 0; f < inputFaces; ++f)
+    {
+        position[order[f]] = f;
+        std::copy_n(i.begin() + 3 * order[f], 3, indices.begin() + 3 * f);
+    }
+
+    // the faces of a collapse are now consecutive, the corners point into the reordered indices
+    corners.resize(log.corners.size());
+    for (size_t c = 0; c < corners.size(); ++c)
+        corners[c] = 3 * position[log.corners[c] / 3] + log.corners[c] % 3;
+
+    level = 0;
+    faceCount = inputFaces;
+}
+
+bool ProgressiveMesh::collapse()
+{
+    if (level >= collapses.size())
+        return false;
+
+    const CollapseRecord& record = collapses[level++];
+
+    vertices[record.kept] = record.newPosition;
+    for (uint32_t c = 0; c < record.cornerCount; ++c)
+        indices[corners[record.firstCorner + c]] = record.kept;
+
+    faceCount -= record.faceCount;
+    return true;
+}
+
+bool ProgressiveMesh::split()
+{
+    if (level == 0)
+        return false;
+
+    const CollapseRecord& record = collapses[--level];
+
+    vertices[record.kept] = record.keptPosition;
+    for (uint32_t c = 0; c < record.cornerCount; ++c)
+        indices[corners[record.firstCorner + c]] = record.removed;
+
+    faceCount += record.faceCount;
+    return true;
+}
+
+void ProgressiveMesh::setFaceCount(size_t targetFaces)
+{
+    // refine while the finer level still fits into the target
+    while (level > 0 && faceCount + collapses[level - 1].faceCount <= targetFaces)
+        split();
+
+    while (faceCount > targetFaces && collapse()) { }
+}
+
+size_t ProgressiveMesh::getMinFaceCount() const
+{
+    size_t removed = 0;
+    for (auto& record : collapses)
+        removed += record.faceCount;
+
+    return getMaxFaceCount() - removed;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// one edge collapse recorded by the simplifier (a vertex split if applied in reverse)
+struct CollapseRecord
+{
+    uint32_t kept;              // vertex that is moved to newPosition
+    uint32_t removed;           // vertex that is replaced by kept
+
+    glm::vec3 keptPosition;     // position of kept before the collapse
+    glm::vec3 newPosition;
+
+    float cost;
+
+    // ranges in CollapseLog::faces and CollapseLog::corners
+    uint32_t firstFace;
+    uint32_t faceCount;
+    uint32_t firstCorner;
+    uint32_t cornerCount;
+};
+
+// ordered collapse sequence of a simplifier run
+struct CollapseLog
+{
+    std::vector<CollapseRecord> collapses;
+    std::vector<uint32_t> faces;    // faces removed by the collapses (face ids of the input mesh)
+    std::vector<uint32_t> corners;  // corners changed from removed to kept (input face id * 3 + corner)
+
+    void clear()
+    {
+        collapses.clear();
+        faces.clear();
+        corners.clear();
+    }
+};
+
+// Progressive mesh (Hoppe): the input mesh plus its collapse sequence.
+// faces are ordered by the collapse that removes them (faces that are never removed first),
+// so every level of detail is a prefix of the index buffer. moving between levels only
+// applies or undoes the collapses in between.
+class ProgressiveMesh
+{
+private:
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    std::vector<CollapseRecord> collapses;
+    std::vector<uint32_t> corners;  // changed corners as positions in indices
+
+    size_t level = 0;       // number of applied collapses
+    size_t faceCount = 0;   // faces of the current level
+
+public:
+    ProgressiveMesh() = default;
+
+    // build from the input of the simplifier and the log of its run (starts at full detail)
+    ProgressiveMesh(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices, const CollapseLog& log);
+
+    // apply or undo collapses until the face count is the largest count less than or equal to targetFaces
+    void setFaceCount(size_t targetFaces);
+
+    // apply the next collapse or undo the last one, returns false at the coarsest/finest level
+    bool collapse();
+    bool split();
+
+    // vertices and indices of the current level (vertices that are collapsed are not referenced)
+    std::span<const glm::vec3> getVertices() const { return vertices; }
+    std::span<const uint32_t> getIndices() const { return { indices.data(), 3 * faceCount }; }
+
+    size_t getFaceCount() const { return faceCount; }
+    size_t getLevel() const { return level; }
+    size_t getLevelCount() const { return collapses.size(); }
+
+    size_t getMaxFaceCount() const { return indices.size() / 3; }
+    size_t getMinFaceCount() const;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// symmetric 4x4 error quadric stored as its upper triangle (10 instead of 16 scalars).
+// the error of a position p is (p, 1)^T * Q * (p, 1).
+// double quadrics keep the sums of many planes far from the origin free of cancellation noise.
+template<typename Scalar>
+struct BasicQuadric
+{
+    using Vector = glm::vec<3, Scalar>;
+
+    // a2, ab, ac, ad, b2, bc, bd, c2, cd, d2
+    Scalar q[10] = { };
+
+    BasicQuadric() = default;
+
+    // quadric of the plane a*x + b*y + c*z + d = 0
+    static BasicQuadric fromPlane(const glm::vec<4, Scalar>& plane)
+    {
+        BasicQuadric result;
+        result.q[0] = plane.x * plane.x;
+        result.q[1] = plane.x * plane.y;
+        result.q[2] = plane.x * plane.z;
+        result.q[3] = plane.x * plane.w;
+        result.q[4] = plane.y * plane.y;
+        result.q[5] = plane.y * plane.z;
+        result.q[6] = plane.y * plane.w;
+        result.q[7] = plane.z * plane.z;
+        result.q[8] = plane.z * plane.w;
+        result.q[9] = plane.w * plane.w;
+        return result;
+    }
+
+    // value times the identity matrix
+    static BasicQuadric diagonal(Scalar value)
+    {
+        BasicQuadric result;
+        result.q[0] = result.q[4] = result.q[7] = result.q[9] = value;
+        return result;
+    }
+
+    BasicQuadric& operator+=(const BasicQuadric& other)
+    {
+        for (int i = 0; i < 10; ++i)
+            q[i] += other.q[i];
+        return *this;
+    }
+
+    BasicQuadric& operator-=(const BasicQuadric& other)
+    {
+        for (int i = 0; i < 10; ++i)
+            q[i] -= other.q[i];
+        return *this;
+    }
+
+    BasicQuadric operator+(const BasicQuadric& other) const { BasicQuadric result = *this; return result += other; }
+    BasicQuadric operator-(const BasicQuadric& other) const { BasicQuadric result = *this; return result -= other; }
+
+    // error of the position (evaluated in the precision of the quadric)
+    Scalar evaluate(const glm::vec3& position) const
+    {
+        Vector p(position);
+        return p.x * (q[0] * p.x + Scalar(2) * (q[1] * p.y + q[2] * p.z + q[3]))
+            + p.y * (q[4] * p.y + Scalar(2) * (q[5] * p.z + q[6]))
+            + p.z * (q[7] * p.z + Scalar(2) * q[8])
+            + q[9];
+    }
+
+    // position with the minimal error, returns false if the minimum is not unique (nearly singular)
+    bool solve(Vector& p) const
+    {
+        // A * p = b with the upper 3x3 block (Cramer's rule)
+        Vector a0(q[0], q[1], q[2]);
+        Vector a1(q[1], q[4], q[5]);
+        Vector a2(q[2], q[5], q[7]);
+        Vector b(-q[3], -q[6], -q[8]);
+
+        Scalar scale = (q[0] + q[4] + q[7]) / Scalar(3);
+        Scalar det = glm::dot(a0, glm::cross(a1, a2));
+        if (scale <= Scalar(0) || std::abs(det) <= Scalar(1e-3) * scale * scale * scale)
+            return false;
+
+        p = Vector(glm::dot(b, glm::cross(a1, a2)), glm::dot(a0, glm::cross(b, a2)), glm::dot(a0, glm::cross(a1, b))) / det;
+        return true;
+    }
+};
+
+using Quadric = BasicQuadric<float>;
+using QuadricD = BasicQuadric<double>;
+
+// precision of the quadrics and pair costs of a simplifier
+enum class QuadricPrecision
+{
+    Float,
+    Double      // for large coordinates or meshes far from the origin (CAD), where float sums of planes get noisy
+};
@@ -0,0 +1,397 @@
+#include "QuadricKernels.hpp"
+
+#include <atomic>
+#include <climits>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(MS_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MS_TARGET_SSE
+#define MS_TARGET_AVX2
+#elif defined(MS_X86)
+#define MS_TARGET_SSE __attribute__((target("sse2")))
+#define MS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// plane quadric of a single face in the precision of the quadric, the vector kernels follow the same steps lane by lane
+template<typename Scalar>
+static BasicQuadric<Scalar> planeQuadric(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    using Vector = typename BasicQuadric<Scalar>::Vector;
+
+    Vector p0(v0);
+    Vector e1 = Vector(v1) - p0;
+    Vector e2 = Vector(v2) - p0;
+
+    // normal = normalize(cross(e2, e1))
+    Scalar nx = e2.y * e1.z - e2.z * e1.y;
+    Scalar ny = e2.z * e1.x - e2.x * e1.z;
+    Scalar nz = e2.x * e1.y - e2.y * e1.x;
+
+    Scalar scale = Scalar(1) / std::sqrt(nx * nx + ny * ny + nz * nz);
+    nx *= scale;
+    ny *= scale;
+    nz *= scale;
+
+    Scalar d = -(p0.x * nx + p0.y * ny + p0.z * nz);
+    return BasicQuadric<Scalar>::fromPlane(glm::vec<4, Scalar>(nx, ny, nz, d));
+}
+
+template<typename Index, typename Scalar>
+static void computePlaneQuadricsScalar(const glm::vec3* vertices, const Index* indices, size_t firstFace, size_t count, BasicQuadric<Scalar>* quadrics)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Index* f = &indices[3 * (firstFace + i)];
+        quadrics[i] = planeQuadric<Scalar>(vertices[f[0]], vertices[f[1]], vertices[f[2]]);
+    }
+}
+
+template<typename Scalar>
+static void evaluatePairCostsScalar(size_t count, const uint32_t* first, const uint32_t* second, const BasicQuadric<Scalar>* quadrics,
+    const glm::vec3* positions, Scalar* costs)
+{
+    for (size_t i = 0; i < count; ++i)
+        costs[i] = (quadrics[first[i]] + quadrics[second[i]]).evaluate(positions[i]);
+}
+
+#ifdef MS_X86
+
+// 4 lanes, the inputs are loaded lane by lane (SSE2 has no gather)
+template<typename Index>
+MS_TARGET_SSE static void computePlaneQuadricsSSE(const glm::vec3* vertices, const Index* indices, size_t firstFace, size_t count, Quadric* quadrics)
+{
+    size_t batches = count / 4;
+    for (size_t batch = 0; batch < batches; ++batch)
+    {
+        const Index* f = &indices[3 * (firstFace + 4 * batch)];
+
+        __m128 p[3][3];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const glm::vec3& a = vertices[f[corner]];
+            const glm::vec3& b = vertices[f[3 + corner]];
+            const glm::vec3& c = vertices[f[6 + corner]];
+            const glm::vec3& d = vertices[f[9 + corner]];
+            p[corner][0] = _mm_setr_ps(a.x, b.x, c.x, d.x);
+            p[corner][1] = _mm_setr_ps(a.y, b.y, c.y, d.y);
+            p[corner][2] = _mm_setr_ps(a.z, b.z, c.z, d.z);
+        }
+
+        __m128 e1x = _mm_sub_ps(p[1][0], p[0][0]), e1y = _mm_sub_ps(p[1][1], p[0][1]), e1z = _mm_sub_ps(p[1][2], p[0][2]);
+        __m128 e2x = _mm_sub_ps(p[2][0], p[0][0]), e2y = _mm_sub_ps(p[2][1], p[0][1]), e2z = _mm_sub_ps(p[2][2], p[0][2]);
+
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(e2y, e1z), _mm_mul_ps(e2z, e1y));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(e2z, e1x), _mm_mul_ps(e2x, e1z));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(e2x, e1y), _mm_mul_ps(e2y, e1x));
+
+        __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+        __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length2));
+        nx = _mm_mul_ps(nx, scale);
+        ny = _mm_mul_ps(ny, scale);
+        nz = _mm_mul_ps(nz, scale);
+
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p[0][0], nx), _mm_mul_ps(p[0][1], ny)), _mm_mul_ps(p[0][2], nz));
+        __m128 d = _mm_sub_ps(_mm_setzero_ps(), dot);
+
+        alignas(16) float q[10][4];
+        _mm_store_ps(q[0], _mm_mul_ps(nx, nx));
+        _mm_store_ps(q[1], _mm_mul_ps(nx, ny));
+        _mm_store_ps(q[2], _mm_mul_ps(nx, nz));
+        _mm_store_ps(q[3], _mm_mul_ps(nx, d));
+        _mm_store_ps(q[4], _mm_mul_ps(ny, ny));
+        _mm_store_ps(q[5], _mm_mul_ps(ny, nz));
+        _mm_store_ps(q[6], _mm_mul_ps(ny, d));
+        _mm_store_ps(q[7], _mm_mul_ps(nz, nz));
+        _mm_store_ps(q[8], _mm_mul_ps(nz, d));
+        _mm_store_ps(q[9], _mm_mul_ps(d, d));
+
+        for (int lane = 0; lane < 4; ++lane)
+            for (int k = 0; k < 10; ++k)
+                quadrics[4 * batch + lane].q[k] = q[k][lane];
+    }
+
+    computePlaneQuadricsScalar(vertices, indices, firstFace + 4 * batches, count - 4 * batches, quadrics + 4 * batches);
+}
+
+MS_TARGET_SSE static void evaluatePairCostsSSE(size_t count, const uint32_t* first, const uint32_t* second, const Quadric* quadrics,
+    const glm::vec3* positions, float* costs)
+{
+    size_t batches = count / 4;
+    for (size_t batch = 0; batch < batches; ++batch)
+    {
+        size_t i = 4 * batch;
+        const Quadric* a[4] = { &quadrics[first[i]], &quadrics[first[i + 1]], &quadrics[first[i + 2]], &quadrics[first[i + 3]] };
+        const Quadric* b[4] = { &quadrics[second[i]], &quadrics[second[i + 1]], &quadrics[second[i + 2]], &quadrics[second[i + 3]] };
+
+        __m128 q[10];
+        for (int k = 0; k < 10; ++k)
+        {
+            q[k] = _mm_add_ps(_mm_setr_ps(a[0]->q[k], a[1]->q[k], a[2]->q[k], a[3]->q[k]),
+                _mm_setr_ps(b[0]->q[k], b[1]->q[k], b[2]->q[k], b[3]->q[k]));
+        }
+
+        const glm::vec3* p = &positions[i];
+        __m128 x = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+        __m128 y = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+        __m128 z = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+        __m128 two = _mm_set1_ps(2.0f);
+
+        // same terms as Quadric::evaluate
+        __m128 tx = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(q[0], x), _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(q[1], y), _mm_mul_ps(q[2], z)), q[3]))));
+        __m128 ty = _mm_mul_ps(y, _mm_add_ps(_mm_mul_ps(q[4], y), _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(q[5], z), q[6]))));
+        __m128 tz = _mm_mul_ps(z, _mm_add_ps(_mm_mul_ps(q[7], z), _mm_mul_ps(two, q[8])));
+
+        _mm_storeu_ps(&costs[i], _mm_add_ps(_mm_add_ps(_mm_add_ps(tx, ty), tz), q[9]));
+    }
+
+    evaluatePairCostsScalar(count - 4 * batches, first + 4 * batches, second + 4 * batches, quadrics, positions + 4 * batches, costs + 4 * batches);
+}
+
+// 8 lanes, the inputs are gathered (16 bit indices are loaded lane by lane, a 32 bit gather could read past the buffer)
+template<typename Index>
+MS_TARGET_AVX2 static void computePlaneQuadricsAVX2(const glm::vec3* vertices, const Index* indices, size_t firstFace, size_t count, Quadric* quadrics)
+{
+    const float* positions = (const float*)vertices;
+    const __m256i faceOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256i three = _mm256_set1_epi32(3);
+
+    size_t batches = count / 8;
+    for (size_t batch = 0; batch < batches; ++batch)
+    {
+        const Index* f = &indices[3 * (firstFace + 8 * batch)];
+
+        __m256 p[3][3];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            __m256i corners;
+            if constexpr (sizeof(Index) == 4)
+                corners = _mm256_i32gather_epi32((const int*)f + corner, faceOffsets, 4);
+            else
+                corners = _mm256_setr_epi32(f[corner], f[3 + corner], f[6 + corner], f[9 + corner], f[12 + corner], f[15 + corner], f[18 + corner], f[21 + corner]);
+
+            __m256i vertex = _mm256_mullo_epi32(corners, three);
+            p[corner][0] = _mm256_i32gather_ps(positions, vertex, 4);
+            p[corner][1] = _mm256_i32gather_ps(positions + 1, vertex, 4);
+            p[corner][2] = _mm256_i32gather_ps(positions + 2, vertex, 4);
+        }
+
+        __m256 e1x = _mm256_sub_ps(p[1][0], p[0][0]), e1y = _mm256_sub_ps(p[1][1], p[0][1]), e1z = _mm256_sub_ps(p[1][2], p[0][2]);
+        __m256 e2x = _mm256_sub_ps(p[2][0], p[0][0]), e2y = _mm256_sub_ps(p[2][1], p[0][1]), e2z = _mm256_sub_ps(p[2][2], p[0][2]);
+
+        __m256 nx = _mm256_sub_ps(_mm256_mul_ps(e2y, e1z), _mm256_mul_ps(e2z, e1y));
+        __m256 ny = _mm256_sub_ps(_mm256_mul_ps(e2z, e1x), _mm256_mul_ps(e2x, e1z));
+        __m256 nz = _mm256_sub_ps(_mm256_mul_ps(e2x, e1y), _mm256_mul_ps(e2y, e1x));
+
+        __m256 length2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz));
+        __m256 scale = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length2));
+        nx = _mm256_mul_ps(nx, scale);
+        ny = _mm256_mul_ps(ny, scale);
+        nz = _mm256_mul_ps(nz, scale);
+
+        __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p[0][0], nx), _mm256_mul_ps(p[0][1], ny)), _mm256_mul_ps(p[0][2], nz));
+        __m256 d = _mm256_sub_ps(_mm256_setzero_ps(), dot);
+
+        alignas(32) float q[10][8];
+        _mm256_store_ps(q[0], _mm256_mul_ps(nx, nx));
+        _mm256_store_ps(q[1], _mm256_mul_ps(nx, ny));
+        _mm256_store_ps(q[2], _mm256_mul_ps(nx, nz));
+        _mm256_store_ps(q[3], _mm256_mul_ps(nx, d));
+        _mm256_store_ps(q[4], _mm256_mul_ps(ny, ny));
+        _mm256_store_ps(q[5], _mm256_mul_ps(ny, nz));
+        _mm256_store_ps(q[6], _mm256_mul_ps(ny, d));
+        _mm256_store_ps(q[7], _mm256_mul_ps(nz, nz));
+        _mm256_store_ps(q[8], _mm256_mul_ps(nz, d));
+        _mm256_store_ps(q[9], _mm256_mul_ps(d, d));
+
+        for (int lane = 0; lane < 8; ++lane)
+            for (int k = 0; k < 10; ++k)
+                quadrics[8 * batch + lane].q[k] = q[k][lane];
+    }
+
+    computePlaneQuadricsSSE(vertices, indices, firstFace + 8 * batches, count - 8 * batches, quadrics + 8 * batches);
+}
+
+MS_TARGET_AVX2 static void evaluatePairCostsAVX2(size_t count, const uint32_t* first, const uint32_t* second, const Quadric* quadrics,
+    const glm::vec3* positions, float* costs)
+{
+    const float* coefficients = (const float*)quadrics;
+    const __m256i ten = _mm256_set1_epi32(10);
+    const __m256i positionOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+    size_t batches = count / 8;
+    for (size_t batch = 0; batch < batches; ++batch)
+    {
+        size_t i = 8 * batch;
+        __m256i a = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&first[i]), ten);
+        __m256i b = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&second[i]), ten);
+
+        __m256 q[10];
+        for (int k = 0; k < 10; ++k)
+            q[k] = _mm256_add_ps(_mm256_i32gather_ps(coefficients + k, a, 4), _mm256_i32gather_ps(coefficients + k, b, 4));
+
+        const float* p = (const float*)&positions[i];
+        __m256 x = _mm256_i32gather_ps(p, positionOffsets, 4);
+        __m256 y = _mm256_i32gather_ps(p + 1, positionOffsets, 4);
+        __m256 z = _mm256_i32gather_ps(p + 2, positionOffsets, 4);
+        __m256 two = _mm256_set1_ps(2.0f);
+
+        // same terms as Quadric::evaluate
+        __m256 tx = _mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(q[0], x), _mm256_mul_ps(two, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(q[1], y), _mm256_mul_ps(q[2], z)), q[3]))));
+        __m256 ty = _mm256_mul_ps(y, _mm256_add_ps(_mm256_mul_ps(q[4], y), _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(q[5], z), q[6]))));
+        __m256 tz = _mm256_mul_ps(z, _mm256_add_ps(_mm256_mul_ps(q[7], z), _mm256_mul_ps(two, q[8])));
+
+        _mm256_storeu_ps(&costs[i], _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(tx, ty), tz), q[9]));
+    }
+
+    evaluatePairCostsSSE(count - 8 * batches, first + 8 * batches, second + 8 * batches, quadrics, positions + 8 * batches, costs + 8 * batches);
+}
+
+static bool cpuSupports(QuadricKernel kernel)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    switch (kernel)
+    {
+    case QuadricKernel::SSE:   return sse2;
+    case QuadricKernel::AVX2:  return sse2 && avx2;
+    default:                   return true;
+    }
+}
+
+#else
+
+static bool cpuSupports(QuadricKernel kernel)
+{
+    return kernel == QuadricKernel::Scalar;
+}
+
+#endif
+
+struct KernelTable
+{
+    void (*computePlaneQuadrics)(const glm::vec3*, const uint32_t*, size_t, size_t, Quadric*);
+    void (*computePlaneQuadrics16)(const glm::vec3*, const uint16_t*, size_t, size_t, Quadric*);
+    void (*evaluatePairCosts)(size_t, const uint32_t*, const uint32_t*, const Quadric*, const glm::vec3*, float*);
+};
+
+static const KernelTable kernelTables[] =
+{
+    { computePlaneQuadricsScalar<uint32_t, float>, computePlaneQuadricsScalar<uint16_t, float>, evaluatePairCostsScalar<float> },
+#ifdef MS_X86
+    { computePlaneQuadricsSSE<uint32_t>, computePlaneQuadricsSSE<uint16_t>, evaluatePairCostsSSE },
+    { computePlaneQuadricsAVX2<uint32_t>, computePlaneQuadricsAVX2<uint16_t>, evaluatePairCostsAVX2 },
+#endif
+};
+
+// the AVX2 kernels gather with signed 32 bit offsets of up to 10 floats per vertex,
+// larger meshes would overflow them and use the SSE kernels instead
+static constexpr size_t MAX_GATHER_VERTICES = INT32_MAX / 10;
+
+static const KernelTable& getKernelTable(size_t vertexCount)
+{
+    QuadricKernel kernel = getQuadricKernel();
+    if (kernel == QuadricKernel::AVX2 && vertexCount > MAX_GATHER_VERTICES)
+        kernel = QuadricKernel::SSE;
+
+    return kernelTables[(size_t)kernel];
+}
+
+static QuadricKernel getBestKernel()
+{
+    for (int kernel = (int)QuadricKernel::Count - 1; kernel > 0; --kernel)
+    {
+        if (isKernelSupported((QuadricKernel)kernel))
+            return (QuadricKernel)kernel;
+    }
+    return QuadricKernel::Scalar;
+}
+
+static std::atomic<QuadricKernel>& getActiveKernel()
+{
+    static std::atomic<QuadricKernel> kernel = getBestKernel();
+    return kernel;
+}
+
+const char* getKernelName(QuadricKernel kernel)
+{
+    switch (kernel)
+    {
+    case QuadricKernel::Scalar: return "scalar";
+    case QuadricKernel::SSE:    return "sse";
+    case QuadricKernel::AVX2:   return "avx2";
+    default:                    return "unknown";
+    }
+}
+
+bool isKernelSupported(QuadricKernel kernel)
+{
+    if ((size_t)kernel >= sizeof(kernelTables) / sizeof(kernelTables[0]))
+        return false;
+
+    static const bool supported[] = { cpuSupports(QuadricKernel::Scalar), cpuSupports(QuadricKernel::SSE), cpuSupports(QuadricKernel::AVX2) };
+    return supported[(size_t)kernel];
+}
+
+QuadricKernel getQuadricKernel()
+{
+    return getActiveKernel().load(std::memory_order_relaxed);
+}
+
+bool setQuadricKernel(QuadricKernel kernel)
+{
+    if (!isKernelSupported(kernel))
+        return false;
+
+    getActiveKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint32_t* indices, size_t firstFace, size_t count, Quadric* quadrics)
+{
+    getKernelTable(vertexCount).computePlaneQuadrics(vertices, indices, firstFace, count, quadrics);
+}
+
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint16_t* indices, size_t firstFace, size_t count, Quadric* quadrics)
+{
+    getKernelTable(vertexCount).computePlaneQuadrics16(vertices, indices, firstFace, count, quadrics);
+}
+
+void computePlaneQuadrics(const glm::vec3* vertices, size_t, const uint32_t* indices, size_t firstFace, size_t count, QuadricD* quadrics)
+{
+    computePlaneQuadricsScalar(vertices, indices, firstFace, count, quadrics);
+}
+
+void computePlaneQuadrics(const glm::vec3* vertices, size_t, const uint16_t* indices, size_t firstFace, size_t count, QuadricD* quadrics)
+{
+    computePlaneQuadricsScalar(vertices, indices, firstFace, count, quadrics);
+}
+
+void evaluatePairCosts(size_t count, const uint32_t* first, const uint32_t* second, const Quadric* quadrics, size_t quadricCount,
+    const glm::vec3* positions, float* costs)
+{
+    getKernelTable(quadricCount).evaluatePairCosts(count, first, second, quadrics, positions, costs);
+}
+
+void evaluatePairCosts(size_t count, const uint32_t* first, const uint32_t* second, const QuadricD* quadrics, size_t,
+    const glm::vec3* positions, double* costs)
+{
+    evaluatePairCostsScalar(count, first, second, quadrics, positions, costs);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Quadric.hpp"
+
+// instruction sets of the batch kernels, the best supported one is picked at runtime.
+// all kernels use the same operations in the same order and give identical results.
+enum class QuadricKernel
+{
+    Scalar = 0,
+    SSE,
+    AVX2,
+    Count
+};
+
+const char* getKernelName(QuadricKernel kernel);
+
+bool isKernelSupported(QuadricKernel kernel);
+
+// kernel used by the functions below (the best supported one unless it was changed)
+QuadricKernel getQuadricKernel();
+
+// force a kernel (e.g. for benchmarks), returns false if the cpu does not support it
+bool setQuadricKernel(QuadricKernel kernel);
+
+// plane quadrics of count faces starting at firstFace (quadrics[i] belongs to face firstFace + i).
+// double quadrics are computed by the scalar kernel, the vector kernels only have float lanes.
+// vertexCount (quadricCount below) picks a kernel whose gather offsets fit the indices.
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint32_t* indices, size_t firstFace, size_t count, Quadric* quadrics);
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint16_t* indices, size_t firstFace, size_t count, Quadric* quadrics);
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint32_t* indices, size_t firstFace, size_t count, QuadricD* quadrics);
+void computePlaneQuadrics(const glm::vec3* vertices, size_t vertexCount, const uint16_t* indices, size_t firstFace, size_t count, QuadricD* quadrics);
+
+// costs[i] = (quadrics[first[i]] + quadrics[second[i]]).evaluate(positions[i])
+void evaluatePairCosts(size_t count, const uint32_t* first, const uint32_t* second, const Quadric* quadrics, size_t quadricCount,
+    const glm::vec3* positions, float* costs);
+void evaluatePairCosts(size_t count, const uint32_t* first, const uint32_t* second, const QuadricD* quadrics, size_t quadricCount,
+    const glm::vec3* positions, double* costs);
@@ -0,0 +1,116 @@
+#include "SimplifierWorker.hpp"
+
+#include "Instrumentation.hpp"
+
+// collapses between two progress updates
+constexpr size_t PROGRESS_INTERVAL = 256;
+
+SimplifierWorker::~SimplifierWorker()
+{
+    cancel();
+    wait();
+}
+
+bool SimplifierWorker::start(MeshSimplifier& simplifier, size_t target, Job job, size_t setupFaces)
+{
+    if (running)
+        return false;
+
+    // the previous job finished but was not polled
+    wait();
+
+    // setup resets the collapse count
+    startFaces = setupFaces > 0 ? setupFaces : simplifier.getFaceCount();
+    targetFaces = target;
+    startCollapses = setupFaces > 0 ? 0 : simplifier.getCollapseCount();
+    faceCount = startFaces;
+    collapseCount = startCollapses;
+    seconds = 0.0;
+    lastSnapshot = 0.0;
+    startTime = std::chrono::steady_clock::now();
+
+    cancelled = false;
+    running = true;
+
+    thread = std::thread([this, &simplifier, job = std::move(job)]()
+        {
+            MS_TRACE_SCOPE("worker");
+
+            simplifier.setProgressCallback([this](const MeshSimplifier& s) { return onProgress(s); }, PROGRESS_INTERVAL);
+            job(simplifier);
+            simplifier.setProgressCallback(nullptr);
+
+            faceCount = simplifier.getFaceCount();
+            collapseCount = simplifier.getCollapseCount();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            running = false;
+        });
+
+    return true;
+}
+
+bool SimplifierWorker::poll()
+{
+    if (running || !thread.joinable())
+        return false;
+
+    thread.join();
+    return true;
+}
+
+void SimplifierWorker::wait()
+{
+    if (thread.joinable())
+        thread.join();
+}
+
+float SimplifierWorker::getProgress() const
+{
+    if (startFaces <= targetFaces)
+        return 1.0f;
+
+    size_t faces = std::max(faceCount.load(), targetFaces);
+    return (float)(startFaces - faces) / (float)(startFaces - targetFaces);
+}
+
+double SimplifierWorker::getCollapsesPerSecond() const
+{
+    double time = seconds;
+    return time > 0.0 ? (double)(collapseCount - startCollapses) / time : 0.0;
+}
+
+bool SimplifierWorker::takeSnapshot(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices)
+{
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    if (!snapshotReady)
+        return false;
+
+    vertices = std::move(snapshotVertices);
+    indices = std::move(snapshotIndices);
+    snapshotReady = false;
+    return true;
+}
+
+bool SimplifierWorker::onProgress(const MeshSimplifier& simplifier)
+{
+    faceCount = simplifier.getFaceCount();
+    collapseCount = simplifier.getCollapseCount();
+
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    seconds = time;
+
+    if (time - lastSnapshot >= snapshotInterval)
+    {
+        // copy outside of the lock, the render thread only waits for the move
+        std::vector<glm::vec3> vertices(simplifier.getVertices().begin(), simplifier.getVertices().end());
+        std::vector<uint32_t> indices(simplifier.getIndices().begin(), simplifier.getIndices().end());
+
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshotVertices = std::move(vertices);
+        snapshotIndices = std::move(indices);
+        snapshotReady = true;
+        lastSnapshot = time;
+    }
+
+    return !cancelled;
+}
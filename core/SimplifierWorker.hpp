@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshSimplifier.hpp"
+
+// runs a job on a simplifier in a worker thread. the simplifier must not be used by any other
+// thread until the job finished, progress and mesh snapshots can be read at any time.
+class SimplifierWorker
+{
+public:
+    using Job = std::function<void(MeshSimplifier&)>;
+
+private:
+    std::thread thread;
+
+    std::atomic<bool> running = false;
+    std::atomic<bool> cancelled = false;
+
+    // progress of the current job (written by the worker)
+    size_t startFaces = 0;
+    size_t targetFaces = 0;
+    size_t startCollapses = 0;
+    std::atomic<size_t> faceCount = 0;
+    std::atomic<size_t> collapseCount = 0;
+    std::atomic<double> seconds = 0.0;
+    std::chrono::steady_clock::time_point startTime;
+
+    // latest copy of the mesh, taken every snapshotInterval seconds
+    std::mutex snapshotMutex;
+    std::vector<glm::vec3> snapshotVertices;
+    std::vector<uint32_t> snapshotIndices;
+    bool snapshotReady = false;
+    double snapshotInterval = 0.1;
+    double lastSnapshot = 0.0;
+
+public:
+    SimplifierWorker() = default;
+    ~SimplifierWorker();
+
+    SimplifierWorker(const SimplifierWorker&) = delete;
+    SimplifierWorker& operator=(const SimplifierWorker&) = delete;
+
+    // run job(simplifier) on the worker thread (e.g. simplifier.run(targetFaces)).
+    // targetFaces is only used for the progress. a job that calls setup first passes the face count
+    // of the new mesh as setupFaces, the progress then starts from it. returns false if a job is still running.
+    bool start(MeshSimplifier& simplifier, size_t targetFaces, Job job, size_t setupFaces = 0);
+
+    // stop the job after the current collapse, the simplifier keeps the mesh simplified so far
+    void cancel() { cancelled = true; }
+
+    // join the thread once the job finished, returns true exactly once per job (call it every frame)
+    bool poll();
+
+    // block until the job finished
+    void wait();
+
+    bool isRunning() const { return running; }
+    bool wasCancelled() const { return cancelled; }
+
+    // faces left, done fraction of the reduction and speed of the current (or last) job
+    size_t getFaceCount() const { return faceCount; }
+    float getProgress() const;
+    double getCollapsesPerSecond() const;
+    double getSeconds() const { return seconds; }
+
+    // move the latest snapshot into the arrays, returns false if there is no new one
+    bool takeSnapshot(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices);
+
+    void setSnapshotInterval(double interval) { snapshotInterval = interval; }
+
+private:
+    // progress callback of the simplifier (on the worker thread)
+    bool onProgress(const MeshSimplifier& simplifier);
+};
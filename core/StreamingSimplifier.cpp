@@ -0,0 +1,510 @@
+#include "StreamingSimplifier.hpp"
+
+#include "Instrumentation.hpp"
+#include "MappedFile.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjLoader.hpp"
+#include "ObjWriter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace fs = std::filesystem;
+
+// cells of the grid along every axis that is used to split the mesh into chunks
+constexpr int STREAMING_GRID = 32;
+
+// more passes do not free enough of the locked borders
+constexpr int STREAMING_MAX_PASSES = 4;
+
+// open chunk files at the same time
+constexpr size_t STREAMING_MAX_CHUNKS = 256;
+
+// mesh stored as two flat binary files (positions and triangle indices)
+struct StreamMesh
+{
+    std::string vertexFile;
+    std::string faceFile;
+
+    size_t vertexCount = 0;
+    size_t faceCount = 0;
+};
+
+// memory mapped view of a StreamMesh, the pages are backed by the files and can be dropped by the system
+struct StreamMeshView
+{
+    MappedFile vertexData;
+    MappedFile faceData;
+
+    std::span<const glm::vec3> vertices;
+    std::span<const uint32_t> indices;
+
+    bool open(const StreamMesh& mesh)
+    {
+        if (!vertexData.open(mesh.vertexFile) || !faceData.open(mesh.faceFile))
+        {
+            printf("Failed to open the intermediate mesh \"%s\".\n", mesh.faceFile.c_str());
+            return false;
+        }
+
+        vertices = { (const glm::vec3*)vertexData.getData(), mesh.vertexCount };
+        indices = { (const uint32_t*)faceData.getData(), 3 * mesh.faceCount };
+        return true;
+    }
+};
+
+// box of grid cells (min inclusive, max exclusive)
+struct CellBox
+{
+    int min[3];
+    int max[3];
+};
+
+// grid over the bounding box of the mesh, every cell belongs to one chunk
+struct ChunkGrid
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    float cellSize = 1.0f;
+
+    std::vector<CellBox> chunks;
+    std::vector<uint32_t> cellChunks;
+
+    int getCell(glm::vec3 p) const
+    {
+        int cell[3];
+        for (int i = 0; i < 3; ++i)
+            cell[i] = std::clamp((int)((p[i] - min[i]) / cellSize), 0, STREAMING_GRID - 1);
+
+        return cell[0] + STREAMING_GRID * (cell[1] + STREAMING_GRID * cell[2]);
+    }
+
+    uint32_t getChunk(glm::vec3 p) const { return cellChunks[getCell(p)]; }
+};
+
+static void removeMesh(const StreamMesh& mesh)
+{
+    std::error_code error;
+    fs::remove(mesh.vertexFile, error);
+    fs::remove(mesh.faceFile, error);
+}
+
+// rewrite the faces of the mesh without the ones that reference vertices past the end (like loadObj)
+static bool removeInvalidFaces(const std::string& input, StreamMesh& mesh)
+{
+    MS_TRACE_SCOPE("remove invalid faces");
+
+    std::string validName = mesh.faceFile + ".valid";
+    FILE* validFile = fopen(validName.c_str(), "wb");
+
+    MappedFile faceData;
+    bool success = validFile && faceData.open(mesh.faceFile);
+
+    size_t validFaces = 0;
+    const uint32_t* indices = success ? (const uint32_t*)faceData.getData() : nullptr;
+    for (size_t face = 0; face < mesh.faceCount && success; ++face)
+    {
+        const uint32_t* f = &indices[3 * face];
+        if (f[0] >= mesh.vertexCount || f[1] >= mesh.vertexCount || f[2] >= mesh.vertexCount)
+            continue;
+
+        success = fwrite(f, sizeof(uint32_t), 3, validFile) == 3;
+        validFaces++;
+    }
+
+    faceData.close();
+    if (validFile) success = fclose(validFile) == 0 && success;
+
+    std::error_code error;
+    if (success)
+        fs::rename(validName, mesh.faceFile, error);
+
+    if (!success || error)
+    {
+        fs::remove(validName, error);
+        printf("Failed to write the intermediate mesh \"%s\".\n", mesh.faceFile.c_str());
+        return false;
+    }
+
+    printf("Skipped %zd faces with invalid indices in \"%s\".\n", mesh.faceCount - validFaces, input.c_str());
+    mesh.faceCount = validFaces;
+    return true;
+}
+
+// convert the .obj file into a StreamMesh without keeping it in memory
+static bool convertObj(const std::string& input, StreamMesh& mesh)
+{
+    MS_TRACE_SCOPE("convert");
+
+    FILE* vertexFile = fopen(mesh.vertexFile.c_str(), "wb");
+    FILE* faceFile = fopen(mesh.faceFile.c_str(), "wb");
+
+    // faces can reference vertices further down the file, they are checked once all vertices are known
+    uint32_t maxIndex = 0;
+    bool success = vertexFile && faceFile && streamObj(input,
+        [&](const glm::vec3& v)
+        {
+            fwrite(&v, sizeof(glm::vec3), 1, vertexFile);
+            mesh.vertexCount++;
+        },
+        [&](uint32_t i0, uint32_t i1, uint32_t i2)
+        {
+            uint32_t face[] = { i0, i1, i2 };
+            fwrite(face, sizeof(face), 1, faceFile);
+            mesh.faceCount++;
+            maxIndex = std::max({ maxIndex, i0, i1, i2 });
+        });
+
+    if (vertexFile) success = fclose(vertexFile) == 0 && success;
+    if (faceFile) success = fclose(faceFile) == 0 && success;
+
+    if (!success)
+    {
+        printf("Failed to convert \"%s\" into \"%s\".\n", input.c_str(), mesh.faceFile.c_str());
+        return false;
+    }
+
+    if (mesh.faceCount > 0 && maxIndex >= mesh.vertexCount)
+        return removeInvalidFaces(input, mesh);
+
+    return true;
+}
+
+static size_t countFaces(const std::vector<size_t>& histogram, const CellBox& box)
+{
+    size_t count = 0;
+    for (int z = box.min[2]; z < box.max[2]; ++z)
+        for (int y = box.min[1]; y < box.max[1]; ++y)
+            for (int x = box.min[0]; x < box.max[0]; ++x)
+                count += histogram[x + STREAMING_GRID * (y + STREAMING_GRID * z)];
+    return count;
+}
+
+// split the box at the median of its longest axis until every chunk fits maxFaces (or is a single cell)
+static void splitChunks(const std::vector<size_t>& histogram, const CellBox& box, size_t maxFaces, std::vector<CellBox>& chunks)
+{
+    int axis = 0;
+    for (int i = 1; i < 3; ++i)
+    {
+        if (box.max[i] - box.min[i] > box.max[axis] - box.min[axis])
+            axis = i;
+    }
+
+    size_t faces = countFaces(histogram, box);
+    if (faces <= maxFaces || box.max[axis] - box.min[axis] == 1)
+    {
+        chunks.push_back(box);
+        return;
+    }
+
+    // first slab where at least half of the faces are below
+    int split = box.max[axis] - 1;
+    size_t below = 0;
+    for (int s = box.min[axis]; s < box.max[axis] - 1; ++s)
+    {
+        CellBox slab = box;
+        slab.min[axis] = s;
+        slab.max[axis] = s + 1;
+
+        below += countFaces(histogram, slab);
+        if (2 * below >= faces)
+        {
+            split = s + 1;
+            break;
+        }
+    }
+
+    CellBox lower = box;
+    CellBox upper = box;
+    lower.max[axis] = split;
+    upper.min[axis] = split;
+
+    splitChunks(histogram, lower, maxFaces, chunks);
+    splitChunks(histogram, upper, maxFaces, chunks);
+}
+
+// the shifted grid moves the chunk borders away from the borders of the previous pass
+static ChunkGrid createChunkGrid(const StreamMeshView& view, size_t maxFaces, bool shifted)
+{
+    ChunkGrid grid;
+
+    glm::vec3 max = view.vertices[0];
+    grid.min = view.vertices[0];
+    for (auto& v : view.vertices)
+    {
+        grid.min = glm::min(grid.min, v);
+        max = glm::max(max, v);
+    }
+
+    glm::vec3 extent = max - grid.min;
+    float longest = std::max(extent.x, std::max(extent.y, extent.z));
+    grid.cellSize = longest > 0.0f ? longest / (STREAMING_GRID - 1) : 1.0f;
+
+    if (shifted)
+        grid.min -= glm::vec3(0.5f * grid.cellSize);
+
+    // faces belong to the cell of their first vertex
+    std::vector<size_t> histogram(STREAMING_GRID * STREAMING_GRID * STREAMING_GRID, 0);
+    for (size_t face = 0; face < view.indices.size() / 3; ++face)
+    {
+        uint32_t v0 = view.indices[3 * face];
+        if (v0 < view.vertices.size())
+            histogram[grid.getCell(view.vertices[v0])]++;
+    }
+
+    CellBox all = { { 0, 0, 0 }, { STREAMING_GRID, STREAMING_GRID, STREAMING_GRID } };
+    splitChunks(histogram, all, maxFaces, grid.chunks);
+
+    grid.cellChunks.resize(histogram.size());
+    for (uint32_t chunk = 0; chunk < grid.chunks.size(); ++chunk)
+    {
+        const CellBox& box = grid.chunks[chunk];
+        for (int z = box.min[2]; z < box.max[2]; ++z)
+            for (int y = box.min[1]; y < box.max[1]; ++y)
+                for (int x = box.min[0]; x < box.max[0]; ++x)
+                    grid.cellChunks[x + STREAMING_GRID * (y + STREAMING_GRID * z)] = chunk;
+    }
+
+    return grid;
+}
+
+// simplify every chunk of the mesh to about ratio of its faces and stitch the results into output
+static bool simplifyChunks(const StreamMesh& input, StreamMesh& output, const fs::path& temp, size_t budgetFaces, float ratio, bool shifted,
+    size_t threadCount, QuadricPrecision precision)
+{
+    MS_TRACE_SCOPE("pass");
+
+    StreamMeshView view;
+    if (!view.open(input))
+        return false;
+
+    // too many chunks would exceed the open file limit, they get bigger than the budget instead
+    size_t maxFaces = std::max(budgetFaces, input.faceCount / STREAMING_MAX_CHUNKS + 1);
+    if (maxFaces > budgetFaces)
+        printf("The mesh needs more than %zd chunks, the chunks exceed the memory budget.\n", STREAMING_MAX_CHUNKS);
+
+    ChunkGrid grid = createChunkGrid(view, maxFaces, shifted);
+    size_t chunkCount = grid.chunks.size();
+
+    // sort the faces into one file per chunk and collect the vertices on the chunk borders
+    std::vector<std::string> chunkNames(chunkCount);
+    std::vector<FILE*> chunkFiles(chunkCount, nullptr);
+    std::vector<size_t> chunkFaces(chunkCount, 0);
+    std::vector<uint32_t> lockedIds;
+    bool success = true;
+    {
+        MS_TRACE_SCOPE("split");
+
+        uint32_t vertexCount = (uint32_t)input.vertexCount;
+        for (size_t face = 0; face < input.faceCount && success; ++face)
+        {
+            const uint32_t* f = &view.indices[3 * face];
+            if (f[0] >= vertexCount || f[1] >= vertexCount || f[2] >= vertexCount)
+                continue;
+
+            uint32_t chunk = grid.getChunk(view.vertices[f[0]]);
+
+            // faces across a border lock all of their vertices in every chunk
+            if (grid.getChunk(view.vertices[f[1]]) != chunk || grid.getChunk(view.vertices[f[2]]) != chunk)
+                lockedIds.insert(lockedIds.end(), f, f + 3);
+
+            if (!chunkFiles[chunk])
+            {
+                chunkNames[chunk] = (temp / ("chunk" + std::to_string(chunk) + ".faces")).string();
+                chunkFiles[chunk] = fopen(chunkNames[chunk].c_str(), "wb");
+            }
+
+            success = chunkFiles[chunk] && fwrite(f, sizeof(uint32_t), 3, chunkFiles[chunk]) == 3;
+            chunkFaces[chunk]++;
+        }
+
+        for (FILE* file : chunkFiles)
+        {
+            if (file) success = fclose(file) == 0 && success;
+        }
+
+        std::sort(lockedIds.begin(), lockedIds.end());
+        lockedIds.erase(std::unique(lockedIds.begin(), lockedIds.end()), lockedIds.end());
+    }
+
+    FILE* vertexFile = fopen(output.vertexFile.c_str(), "wb");
+    FILE* faceFile = fopen(output.faceFile.c_str(), "wb");
+    success = success && vertexFile && faceFile;
+
+    // output index of every locked vertex (shared by all chunks)
+    std::vector<uint32_t> lockedOutput(lockedIds.size(), UINT32_MAX);
+    output.vertexCount = 0;
+    output.faceCount = 0;
+
+    for (size_t chunk = 0; chunk < chunkCount && success; ++chunk)
+    {
+        if (chunkFaces[chunk] == 0)
+            continue;
+
+        MS_TRACE_SCOPE("chunk");
+
+        MappedFile chunkData;
+        success = chunkData.open(chunkNames[chunk]);
+        if (!success)
+            break;
+
+        std::span<const uint32_t> chunkIndices((const uint32_t*)chunkData.getData(), 3 * chunkFaces[chunk]);
+
+        // the input vertices of the chunk in ascending order define the local indices
+        std::vector<uint32_t> globalIds(chunkIndices.begin(), chunkIndices.end());
+        std::sort(globalIds.begin(), globalIds.end());
+        globalIds.erase(std::unique(globalIds.begin(), globalIds.end()), globalIds.end());
+
+        std::vector<glm::vec3> vertices(globalIds.size());
+        std::vector<uint8_t> locked(globalIds.size());
+        for (size_t v = 0; v < globalIds.size(); ++v)
+        {
+            vertices[v] = view.vertices[globalIds[v]];
+            locked[v] = std::binary_search(lockedIds.begin(), lockedIds.end(), globalIds[v]);
+        }
+
+        std::vector<uint32_t> indices(chunkIndices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = (uint32_t)(std::lower_bound(globalIds.begin(), globalIds.end(), chunkIndices[i]) - globalIds.begin());
+
+        chunkData.close();
+        std::error_code error;
+        fs::remove(chunkNames[chunk], error);
+
+        // chunks are usually small enough for 16 bit indices
+        visitMeshSimplifier(vertices.size(), precision, [&](auto& simplifier)
+            {
+                simplifier.setThreadCount(threadCount);
+                simplifier.setLockedVertices(std::move(locked));
+                simplifier.setup(std::move(vertices), std::move(indices));
+                simplifier.run((size_t)(chunkFaces[chunk] * ratio));
+
+                // append the chunk, the locked vertices are written by the first chunk that uses them
+                std::span<const glm::vec3> simplifiedVertices = simplifier.getVertices();
+                auto simplifiedIndices = simplifier.getIndices();
+                std::vector<uint32_t> localOutput(simplifiedVertices.size(), UINT32_MAX);
+                std::vector<uint32_t> outputIndices(simplifiedIndices.size());
+                for (size_t i = 0; i < simplifiedIndices.size(); ++i)
+                {
+                    uint32_t index = simplifiedIndices[i];
+                    uint32_t* outputIndex = &localOutput[index];
+                    if (simplifier.isLocked(index))
+                        outputIndex = &lockedOutput[std::lower_bound(lockedIds.begin(), lockedIds.end(), globalIds[index]) - lockedIds.begin()];
+
+                    if (*outputIndex == UINT32_MAX)
+                    {
+                        *outputIndex = (uint32_t)output.vertexCount++;
+                        fwrite(&simplifiedVertices[index], sizeof(glm::vec3), 1, vertexFile);
+                    }
+
+                    outputIndices[i] = *outputIndex;
+                }
+
+                success = fwrite(outputIndices.data(), sizeof(uint32_t), outputIndices.size(), faceFile) == outputIndices.size();
+                output.faceCount += simplifier.getFaceCount();
+            });
+    }
+
+    if (vertexFile) success = fclose(vertexFile) == 0 && success;
+    if (faceFile) success = fclose(faceFile) == 0 && success;
+
+    // chunk files are left behind after errors
+    for (auto& name : chunkNames)
+    {
+        std::error_code error;
+        if (!name.empty()) fs::remove(name, error);
+    }
+
+    if (!success)
+        printf("Failed to write the intermediate mesh \"%s\".\n", output.faceFile.c_str());
+
+    return success;
+}
+
+// the mesh fits into memory, simplify it to the exact target
+static bool simplifyInMemory(const StreamMesh& mesh, const std::string& output, size_t targetFaces, size_t threadCount, QuadricPrecision precision)
+{
+    MS_TRACE_SCOPE("final");
+
+    return visitMeshSimplifier(mesh.vertexCount, precision, [&](auto& simplifier)
+        {
+            {
+                StreamMeshView view;
+                if (!view.open(mesh))
+                    return false;
+
+                simplifier.setThreadCount(threadCount);
+                simplifier.setup(view.vertices, view.indices);
+            }
+
+            simplifier.run(targetFaces);
+            return writeMesh(output, simplifier.getVertices(), simplifier.getIndices(), {}, threadCount);
+        });
+}
+
+bool simplifyStreaming(const std::string& input, const std::string& output, const StreamingOptions& options)
+{
+    MS_TRACE_SCOPE("streaming");
+
+    fs::path temp = options.tempDirectory.empty() ? fs::path(output + ".parts") : fs::path(options.tempDirectory);
+    std::error_code error;
+    fs::create_directories(temp, error);
+
+    StreamMesh mesh = { (temp / "input.vertices").string(), (temp / "input.faces").string() };
+    bool success = convertObj(input, mesh);
+    if (success && (mesh.vertexCount == 0 || mesh.faceCount == 0))
+    {
+        printf("\"%s\" has no faces.\n", input.c_str());
+        success = false;
+    }
+
+    size_t targetFaces = options.targetFaces > 0 ? options.targetFaces : (size_t)(mesh.faceCount * options.ratio);
+    size_t budgetFaces = std::max<size_t>(1, options.memoryBudget / STREAMING_BYTES_PER_FACE);
+
+    // the passes leave room for the final step to re-simplify the borders, unless the target does not fit anyway
+    size_t passTarget = std::max(targetFaces, std::min(2 * targetFaces, budgetFaces * 3 / 4));
+
+    for (int pass = 0; success && mesh.faceCount > budgetFaces && mesh.faceCount > passTarget && pass < STREAMING_MAX_PASSES; ++pass)
+    {
+        std::string name = "pass" + std::to_string(pass);
+        StreamMesh next = { (temp / (name + ".vertices")).string(), (temp / (name + ".faces")).string() };
+
+        float ratio = (float)passTarget / (float)mesh.faceCount;
+        success = simplifyChunks(mesh, next, temp, budgetFaces, ratio, pass % 2 == 1, options.threadCount, options.precision);
+
+        printf("Streaming pass %d: %zd -> %zd faces\n", pass + 1, mesh.faceCount, next.faceCount);
+        removeMesh(mesh);
+
+        // the locked borders can not be simplified any further
+        bool stalled = next.faceCount >= mesh.faceCount - mesh.faceCount / 100;
+        mesh = next;
+        if (stalled)
+            break;
+    }
+
+    if (success)
+    {
+        if (mesh.faceCount <= budgetFaces)
+        {
+            success = simplifyInMemory(mesh, output, targetFaces, options.threadCount, options.precision);
+        }
+        else
+        {
+            if (mesh.faceCount > targetFaces)
+                printf("The mesh does not fit into the memory budget, it is written with %zd instead of %zd faces.\n", mesh.faceCount, targetFaces);
+
+            StreamMeshView view;
+            success = view.open(mesh) && writeMesh(output, view.vertices, view.indices, {}, options.threadCount);
+        }
+    }
+
+    removeMesh(mesh);
+    if (options.tempDirectory.empty())
+        fs::remove_all(temp, error);
+
+    return success;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include "Quadric.hpp"
+
+// estimated memory of the simplifier per face (vertex data, quadrics, adjacency, pairs and heap),
+// measured peaks are about 200 bytes
+constexpr size_t STREAMING_BYTES_PER_FACE = 256;
+
+struct StreamingOptions
+{
+    float ratio = 0.5f;         // target face count relative to the input
+    size_t targetFaces = 0;     // absolute target face count (overrides ratio)
+
+    size_t memoryBudget = size_t(1) << 30;  // bytes the simplifier may use at once
+    size_t threadCount = 0;                 // threads of every simplifier (0 uses all hardware threads)
+    QuadricPrecision precision = QuadricPrecision::Float;
+
+    std::string tempDirectory;  // intermediate files (default: <output>.parts, removed afterwards)
+};
+
+// simplify an .obj file that does not fit into memory. the mesh is converted into flat binary
+// files and split into spatial chunks that fit the memory budget. every chunk is simplified
+// with the vertices on its border locked and the results are stitched on disk. further passes
+// on a shifted grid free the old borders until the mesh fits into the budget, the last step
+// re-simplifies the whole mesh in memory. returns false if a file could not be read or written.
+bool simplifyStreaming(const std::string& input, const std::string& output, const StreamingOptions& options);
@@ -0,0 +1,195 @@
+#include "VertexWelder.hpp"
+
+#include "Instrumentation.hpp"
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+// cell of the spatial hash, epsilon sized or the bit pattern of the position when welding exact duplicates
+struct WeldCell
+{
+    int32_t x, y, z;
+
+    bool operator==(const WeldCell&) const = default;
+};
+
+static int32_t toCell(float value, float scale)
+{
+    double cell = std::floor((double)value * scale);
+    return (int32_t)std::clamp(cell, (double)INT32_MIN, (double)INT32_MAX);
+}
+
+static WeldCell getCell(const glm::vec3& p, float scale)
+{
+    // + 0.0f turns -0 into 0, they are equal positions
+    if (scale == 0.0f)
+        return { std::bit_cast<int32_t>(p.x + 0.0f), std::bit_cast<int32_t>(p.y + 0.0f), std::bit_cast<int32_t>(p.z + 0.0f) };
+
+    return { toCell(p.x, scale), toCell(p.y, scale), toCell(p.z, scale) };
+}
+
+// vertex of the spatial hash with a copy of its position
+struct WeldEntry
+{
+    glm::vec3 position;
+    uint32_t vertex;
+};
+
+static uint32_t hashCell(const WeldCell& cell, uint32_t mask)
+{
+    return ((uint32_t)cell.x * 73856093u ^ (uint32_t)cell.y * 19349663u ^ (uint32_t)cell.z * 83492791u) & mask;
+}
+
+WeldStats weldVertices(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, float epsilon, size_t threadCount,
+    std::span<MeshObject> objects)
+{
+    MS_TRACE_SCOPE("weld");
+    auto start = std::chrono::steady_clock::now();
+
+    WeldStats stats;
+    stats.inputVertices = vertices.size();
+
+    size_t vertexCount = vertices.size();
+    bool exact = !(epsilon > 0.0f);
+    // cells are 2 * epsilon wide, so a vertex only has to look into a neighbouring cell if it is
+    // less than epsilon away from the border (1 cell for most vertices, at most 8)
+    float scale = exact ? 0.0f : 0.5f / epsilon;
+    float epsilon2 = exact ? 0.0f : epsilon * epsilon;
+
+    // spatial hash with one bucket per vertex (rounded up to a power of two), filled by counting sort.
+    // the entries keep a copy of the position so scanning a bucket reads contiguous memory.
+    uint32_t bucketCount = std::bit_ceil((uint32_t)std::max<size_t>(vertexCount, 1));
+    uint32_t mask = bucketCount - 1;
+
+    std::vector<WeldEntry> entries(vertexCount);
+    std::vector<uint32_t> offsets(bucketCount + 1, 0);
+    {
+        MS_TRACE_SCOPE("hash");
+
+        std::vector<uint32_t> vertexBuckets(vertexCount);
+        std::vector<std::atomic<uint32_t>> counts(bucketCount);
+        parallelFor(vertexCount, threadCount, [&](size_t v)
+            {
+                vertexBuckets[v] = hashCell(getCell(vertices[v], scale), mask);
+                counts[vertexBuckets[v]].fetch_add(1, std::memory_order_relaxed);
+            });
+
+        for (uint32_t bucket = 0; bucket < bucketCount; ++bucket)
+        {
+            offsets[bucket + 1] = offsets[bucket] + counts[bucket].load(std::memory_order_relaxed);
+            counts[bucket].store(offsets[bucket], std::memory_order_relaxed);
+        }
+
+        // the order inside a bucket depends on the threads, the lookup below does not
+        parallelFor(vertexCount, threadCount, [&](size_t v)
+            {
+                uint32_t slot = counts[vertexBuckets[v]].fetch_add(1, std::memory_order_relaxed);
+                entries[slot] = { vertices[v], (uint32_t)v };
+            });
+    }
+
+    // lowest vertex within epsilon (in the cells overlapping the epsilon box around the vertex).
+    // hash collisions are filtered by the distance test. walks the buckets for locality.
+    std::vector<uint32_t> remap(vertexCount);
+    {
+        MS_TRACE_SCOPE("lookup");
+
+        auto findLowest = [&](uint32_t bucket, const WeldEntry& entry, uint32_t best)
+        {
+            for (uint32_t i = offsets[bucket]; i < offsets[bucket + 1]; ++i)
+            {
+                const WeldEntry& other = entries[i];
+                if (other.vertex >= best)
+                    continue;
+
+                glm::vec3 d = other.position - entry.position;
+                if (exact ? other.position == entry.position : glm::dot(d, d) <= epsilon2)
+                    best = other.vertex;
+            }
+            return best;
+        };
+
+        parallelForChunks(bucketCount, threadCount, [&](size_t, size_t begin, size_t end)
+            {
+                for (size_t bucket = begin; bucket < end; ++bucket)
+                {
+                    for (uint32_t i = offsets[bucket]; i < offsets[bucket + 1]; ++i)
+                    {
+                        const WeldEntry& entry = entries[i];
+
+                        // equal positions are always in the same bucket
+                        if (exact)
+                        {
+                            remap[entry.vertex] = findLowest((uint32_t)bucket, entry, entry.vertex);
+                            continue;
+                        }
+
+                        WeldCell first = getCell(entry.position - glm::vec3(epsilon), scale);
+                        WeldCell last = getCell(entry.position + glm::vec3(epsilon), scale);
+
+                        uint32_t best = entry.vertex;
+                        for (int32_t z = first.z; z <= last.z; ++z)
+                        for (int32_t y = first.y; y <= last.y; ++y)
+                        for (int32_t x = first.x; x <= last.x; ++x)
+                            best = findLowest(hashCell({ x, y, z }, mask), entry, best);
+
+                        remap[entry.vertex] = best;
+                    }
+                }
+            });
+    }
+
+    // follow the chains (the target always has a lower index) and compact the vertices in order
+    uint32_t outputCount = 0;
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] == v)
+        {
+            vertices[outputCount] = vertices[v];
+            remap[v] = outputCount++;
+        }
+        else
+        {
+            remap[v] = remap[remap[v]];
+        }
+    }
+
+    vertices.resize(outputCount);
+    vertices.shrink_to_fit();
+    stats.outputVertices = outputCount;
+
+    parallelFor(indices.size(), threadCount, [&](size_t i) { indices[i] = remap[indices[i]]; });
+
+    // drop faces that lost a corner (objects are in face order)
+    size_t faceCount = 0;
+    size_t object = 0;
+    for (size_t face = 0; face < indices.size() / 3; ++face)
+    {
+        for (; object < objects.size() && objects[object].firstFace == face; ++object)
+            objects[object].firstFace = (uint32_t)faceCount;
+
+        uint32_t i0 = indices[3 * face], i1 = indices[3 * face + 1], i2 = indices[3 * face + 2];
+        if (i0 == i1 || i1 == i2 || i0 == i2)
+            continue;
+
+        indices[3 * faceCount] = i0;
+        indices[3 * faceCount + 1] = i1;
+        indices[3 * faceCount + 2] = i2;
+        faceCount++;
+    }
+
+    for (; object < objects.size(); ++object)
+        objects[object].firstFace = (uint32_t)faceCount;
+
+    for (size_t i = 0; i < objects.size(); ++i)
+        objects[i].faceCount = (i + 1 < objects.size() ? objects[i + 1].firstFace : (uint32_t)faceCount) - objects[i].firstFace;
+
+    stats.degenerateFaces = indices.size() / 3 - faceCount;
+    indices.resize(3 * faceCount);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshObject.hpp"
+
+struct WeldStats
+{
+    size_t inputVertices = 0;
+    size_t outputVertices = 0;
+    size_t degenerateFaces = 0;     // faces removed because two corners were welded together
+    double seconds = 0.0;
+};
+
+// merge vertices whose positions are at most epsilon apart (0 merges equal positions only) and
+// remap the indices. every vertex joins the lowest index within epsilon, chains of close vertices
+// end up in one vertex. the result does not depend on the thread count.
+// the face ranges of the objects are moved along when degenerate faces are removed.
+WeldStats weldVertices(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices, float epsilon, size_t threadCount = 0,
+    std::span<MeshObject> objects = {});
@@ -0,0 +1,523 @@
+#include "Generators.hpp"
+#include "Memory.hpp"
+
+#include "MeshData.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjWriter.hpp"
+#include "QuadricKernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// fixed workload, changing it requires a new baseline
+static const float RATIO = 0.1f;
+static const uint32_t SEED = 1;
+static const size_t GENERATED_FACES = 100000;
+static const size_t MIN_MODEL_FACES = 1000;    // smaller models finish below the timing floor and vanish at the ratio
+static const char* FAMILIES[] = { "sphere", "heightfield", "torusknot" };
+
+struct Options
+{
+    std::string baseline = "perf/baseline.json";
+    std::string resDir = "res";
+
+    size_t repeats = 5;
+    size_t threads = 1;
+
+    // a timing regresses if its median exceeds the baseline by all of these
+    float sigmas = 4.0f;        // robust standard deviations (1.4826 * MAD of both runs)
+    float tolerance = 0.10f;    // fraction of the baseline median
+    float minimumMs = 2.0f;     // absolute difference
+    float memoryTolerance = 0.10f;
+
+    bool update = false;
+};
+
+// median and median absolute deviation of the repeated runs
+struct Timing
+{
+    double median = 0.0;
+    double mad = 0.0;
+};
+
+struct CaseResult
+{
+    std::string name;
+
+    size_t faces = 0;
+    size_t targetFaces = 0;
+    size_t resultFaces = 0;
+    size_t resultVertices = 0;
+    std::string hash;
+
+    // milliseconds
+    Timing load;
+    Timing setup;
+    Timing run;
+
+    double peakMemory = 0.0;    // MB, median (0 if the peak can not be reset)
+};
+
+static void printUsage()
+{
+    printf("usage: perfcheck [options]\n");
+    printf("\n");
+    printf("simplifies the models in res/ and generated meshes at fixed targets and compares the\n");
+    printf("timings, peak memory and results against a baseline. exits with 1 on a regression.\n");
+    printf("\n");
+    printf("options:\n");
+    printf("  --baseline <file>     baseline json (default: perf/baseline.json)\n");
+    printf("  --res <dir>           directory with .obj models (default: res)\n");
+    printf("  --repeats <n>         timed runs per mesh after one warm-up run (default: 5)\n");
+    printf("  --threads <n>         threads used by setup (default: 1)\n");
+    printf("  --sigmas <k>          allowed robust standard deviations (default: 4)\n");
+    printf("  --tolerance <f>       allowed slowdown relative to the baseline (default: 0.1)\n");
+    printf("  --update-baseline     write the results as the new baseline\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--baseline") == 0 && hasValue)         options.baseline = argv[++i];
+        else if (strcmp(arg, "--res") == 0 && hasValue)         options.resDir = argv[++i];
+        else if (strcmp(arg, "--repeats") == 0 && hasValue)     options.repeats = std::max<size_t>(1, (size_t)atoll(argv[++i]));
+        else if (strcmp(arg, "--threads") == 0 && hasValue)     options.threads = (size_t)atoll(argv[++i]);
+        else if (strcmp(arg, "--sigmas") == 0 && hasValue)      options.sigmas = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--tolerance") == 0 && hasValue)   options.tolerance = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--update-baseline") == 0)         options.update = true;
+        else
+        {
+            printf("Unknown option \"%s\".\n", arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static Timing summarize(const std::vector<double>& values)
+{
+    Timing timing;
+    timing.median = median(values);
+
+    std::vector<double> deviations;
+    for (double value : values)
+        deviations.push_back(std::abs(value - timing.median));
+    timing.mad = median(deviations);
+
+    return timing;
+}
+
+// FNV-1a of the faces and the positions of the referenced vertices in order of their first use,
+// independent of the vertices the simplifier keeps but no longer references
+static std::string hashGeometry(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices, size_t& vertexCount)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](uint32_t value)
+        {
+            for (int byte = 0; byte < 4; ++byte)
+            {
+                hash ^= (value >> (8 * byte)) & 0xff;
+                hash *= 1099511628211ull;
+            }
+        };
+
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    vertexCount = 0;
+    for (uint32_t index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = (uint32_t)vertexCount++;
+
+            uint32_t bits[3];
+            memcpy(bits, &vertices[index], sizeof(bits));
+            add(bits[0]);
+            add(bits[1]);
+            add(bits[2]);
+        }
+
+        add(remap[index]);
+    }
+
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+    return text;
+}
+
+// load the .obj file (no cache), setup and run, repeated
+static CaseResult measure(const std::string& name, const fs::path& objFile, const Options& options)
+{
+    CaseResult result;
+    result.name = name;
+
+    std::vector<double> load, setup, run, memory;
+    bool memoryValid = true;
+
+    // the first run warms up the caches and the allocator and is not timed
+    for (size_t repeat = 0; repeat <= options.repeats; ++repeat)
+    {
+        bool timed = repeat > 0;
+        memoryValid &= resetPeakMemory();
+
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indices;
+        {
+            auto start = std::chrono::steady_clock::now();
+            MeshData data(objFile.string(), false);
+            double milliseconds = millisecondsSince(start);
+            if (timed) load.push_back(milliseconds);
+            data.release(vertices, indices);
+        }
+
+        result.faces = indices.size() / 3;
+        result.targetFaces = (size_t)(result.faces * RATIO);
+
+        MeshSimplifier simplifier;
+        simplifier.setThreadCount(options.threads);
+
+        auto start = std::chrono::steady_clock::now();
+        simplifier.setup(std::move(vertices), std::move(indices));
+        double setupMilliseconds = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        simplifier.run(result.targetFaces);
+        double runMilliseconds = millisecondsSince(start);
+
+        if (timed)
+        {
+            setup.push_back(setupMilliseconds);
+            run.push_back(runMilliseconds);
+            memory.push_back(getPeakMemory() / 1048576.0);
+        }
+
+        // every run has to produce the same mesh, the hash of the last one is kept
+        size_t vertexCount = 0;
+        std::string hash = hashGeometry(simplifier.getVertices(), simplifier.getIndices(), vertexCount);
+        if (repeat > 0 && hash != result.hash)
+            printf("%s: the result differs between runs.\n", name.c_str());
+
+        result.resultFaces = simplifier.getFaceCount();
+        result.resultVertices = vertexCount;
+        result.hash = hash;
+    }
+
+    result.load = summarize(load);
+    result.setup = summarize(setup);
+    result.run = summarize(run);
+    result.peakMemory = memoryValid ? median(memory) : 0.0;
+
+    return result;
+}
+
+static std::vector<CaseResult> runWorkload(const Options& options)
+{
+    std::error_code error;
+    fs::path tempDir = fs::temp_directory_path(error) / "meshsimplifier-perfcheck";
+    fs::create_directories(tempDir, error);
+
+    std::vector<CaseResult> results;
+
+    std::vector<fs::path> models;
+    for (auto& entry : fs::directory_iterator(options.resDir, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".obj")
+            models.push_back(entry.path());
+    }
+    std::sort(models.begin(), models.end());
+
+    for (auto& model : models)
+    {
+        if (MeshData(model.string(), false).getFaceCount() < MIN_MODEL_FACES)
+        {
+            printf("Skipping %s (less than %zd faces)\n", model.stem().string().c_str(), MIN_MODEL_FACES);
+            continue;
+        }
+
+        printf("Measuring %s\n", model.stem().string().c_str());
+        results.push_back(measure("res/" + model.stem().string(), model, options));
+    }
+
+    for (const char* family : FAMILIES)
+    {
+        GeneratedMesh mesh;
+        generateMesh(family, GENERATED_FACES, SEED, mesh);
+
+        fs::path objFile = tempDir / (mesh.name + ".obj");
+        if (!writeObj(objFile.string(), mesh.vertices, mesh.indices))
+            continue;
+
+        std::string name = std::string(family) + "/" + mesh.name;
+        mesh = GeneratedMesh();
+
+        printf("Measuring %s\n", name.c_str());
+        results.push_back(measure(name, objFile, options));
+    }
+
+    fs::remove_all(tempDir, error);
+    return results;
+}
+
+static bool writeBaseline(const std::string& filename, const std::vector<CaseResult>& results, const Options& options)
+{
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file)
+    {
+        printf("Failed to open \"%s\" for writing.\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n  \"kernel\": \"%s\",\n  \"threads\": %zd,\n  \"repeats\": %zd,\n  \"cases\": [\n",
+        getKernelName(getQuadricKernel()), options.threads, options.repeats);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& r = results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"faces\": %zd, \"target_faces\": %zd, \"result_faces\": %zd, \"result_vertices\": %zd, \"hash\": \"%s\", "
+            "\"load_ms\": %.3f, \"load_mad_ms\": %.3f, \"setup_ms\": %.3f, \"setup_mad_ms\": %.3f, \"run_ms\": %.3f, \"run_mad_ms\": %.3f, \"peak_rss_mb\": %.1f }%s\n",
+            r.name.c_str(), r.faces, r.targetFaces, r.resultFaces, r.resultVertices, r.hash.c_str(),
+            r.load.median, r.load.mad, r.setup.median, r.setup.mad, r.run.median, r.run.mad, r.peakMemory,
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (fclose(file) != 0)
+    {
+        printf("Failed to write \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+using JsonObject = std::map<std::string, std::string>;
+
+// read the "key": value pairs of a flat object starting at text[pos] == '{', strings without escapes
+static bool readObject(const std::string& text, size_t& pos, JsonObject& object)
+{
+    size_t end = text.find('}', pos);
+    if (end == std::string::npos) return false;
+
+    for (size_t key = text.find('"', pos); key < end; key = text.find('"', pos))
+    {
+        size_t keyEnd = text.find('"', key + 1);
+        size_t colon = text.find(':', keyEnd);
+        size_t value = text.find_first_not_of(" \t\r\n", colon + 1);
+        if (keyEnd >= end || colon >= end || value >= end) return false;
+
+        size_t valueEnd;
+        if (text[value] == '"')
+        {
+            valueEnd = text.find('"', value + 1);
+            object[text.substr(key + 1, keyEnd - key - 1)] = text.substr(value + 1, valueEnd - value - 1);
+            valueEnd++;
+        }
+        else
+        {
+            valueEnd = text.find_first_of(",}", value);
+            object[text.substr(key + 1, keyEnd - key - 1)] = text.substr(value, text.find_last_not_of(" \t\r\n", valueEnd - 1) - value + 1);
+        }
+        pos = valueEnd;
+    }
+
+    pos = end + 1;
+    return true;
+}
+
+static bool readBaseline(const std::string& filename, JsonObject& header, std::vector<JsonObject>& cases)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        printf("Failed to open the baseline \"%s\" (create it with --update-baseline).\n", filename.c_str());
+        return false;
+    }
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string text = stream.str();
+
+    // header values are the ones before the case list
+    size_t list = text.find("\"cases\"");
+    size_t open = text.find('[', list);
+    if (list == std::string::npos || open == std::string::npos)
+    {
+        printf("Invalid baseline \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    std::string headerText = text.substr(0, list) + "}";
+    size_t pos = headerText.find('{');
+    if (pos == std::string::npos || !readObject(headerText, pos, header))
+    {
+        printf("Invalid baseline \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    size_t close = text.find(']', open);
+    for (pos = text.find('{', open); pos < close; pos = text.find('{', pos))
+    {
+        JsonObject object;
+        if (!readObject(text, pos, object))
+        {
+            printf("Invalid baseline \"%s\".\n", filename.c_str());
+            return false;
+        }
+        cases.push_back(std::move(object));
+    }
+
+    return true;
+}
+
+static double getNumber(const JsonObject& object, const char* key)
+{
+    auto it = object.find(key);
+    return it != object.end() ? atof(it->second.c_str()) : 0.0;
+}
+
+static std::string getString(const JsonObject& object, const char* key)
+{
+    auto it = object.find(key);
+    return it != object.end() ? it->second : "";
+}
+
+// compare a timing against the baseline, returns false on a regression
+static bool checkTiming(const char* label, const Timing& current, const JsonObject& baseline, const char* key, const char* madKey, const Options& options)
+{
+    double median = getNumber(baseline, key);
+    double mad = std::max(getNumber(baseline, madKey), current.mad);
+
+    // 1.4826 * MAD estimates the standard deviation of normally distributed noise
+    double allowed = std::max({ options.sigmas * 1.4826 * mad, options.tolerance * median, (double)options.minimumMs });
+    double change = median > 0.0 ? 100.0 * (current.median - median) / median : 0.0;
+    bool regressed = current.median > median + allowed;
+
+    printf("  %-6s %10.2f ms  baseline %10.2f ms  %+7.1f%%  (allowed +%.2f ms)%s\n", label, current.median, median, change, allowed,
+        regressed ? "  REGRESSION" : "");
+    return !regressed;
+}
+
+static bool checkResults(const std::vector<CaseResult>& results, const JsonObject& header, const std::vector<JsonObject>& cases, const Options& options)
+{
+    bool passed = true;
+
+    if ((size_t)getNumber(header, "threads") != options.threads)
+        printf("The baseline was recorded with %zd threads, this run uses %zd.\n", (size_t)getNumber(header, "threads"), options.threads);
+
+    for (auto& r : results)
+    {
+        auto baseline = std::find_if(cases.begin(), cases.end(), [&r](const JsonObject& c) { return getString(c, "name") == r.name; });
+        if (baseline == cases.end())
+        {
+            printf("%s: not in the baseline.\n", r.name.c_str());
+            passed = false;
+            continue;
+        }
+
+        printf("%s\n", r.name.c_str());
+
+        // the workload is deterministic, any difference in the result is a failure
+        bool same = (size_t)getNumber(*baseline, "faces") == r.faces && (size_t)getNumber(*baseline, "result_faces") == r.resultFaces &&
+            (size_t)getNumber(*baseline, "result_vertices") == r.resultVertices && getString(*baseline, "hash") == r.hash;
+        if (!same)
+        {
+            printf("  result %zd faces, %zd vertices, hash %s  baseline %zd faces, %zd vertices, hash %s  MISMATCH\n",
+                r.resultFaces, r.resultVertices, r.hash.c_str(), (size_t)getNumber(*baseline, "result_faces"),
+                (size_t)getNumber(*baseline, "result_vertices"), getString(*baseline, "hash").c_str());
+            passed = false;
+        }
+
+        passed &= checkTiming("load", r.load, *baseline, "load_ms", "load_mad_ms", options);
+        passed &= checkTiming("setup", r.setup, *baseline, "setup_ms", "setup_mad_ms", options);
+        passed &= checkTiming("run", r.run, *baseline, "run_ms", "run_mad_ms", options);
+
+        double memory = getNumber(*baseline, "peak_rss_mb");
+        if (memory > 0.0 && r.peakMemory > 0.0)
+        {
+            bool regressed = r.peakMemory > memory * (1.0 + options.memoryTolerance) + 1.0;
+            printf("  %-6s %10.1f MB  baseline %10.1f MB%s\n", "memory", r.peakMemory, memory, regressed ? "  REGRESSION" : "");
+            passed &= !regressed;
+        }
+    }
+
+    for (auto& c : cases)
+    {
+        std::string name = getString(c, "name");
+        if (std::none_of(results.begin(), results.end(), [&name](const CaseResult& r) { return r.name == name; }))
+        {
+            printf("%s: in the baseline but not measured.\n", name.c_str());
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    JsonObject header;
+    std::vector<JsonObject> cases;
+    if (!options.update)
+    {
+        if (!readBaseline(options.baseline, header, cases))
+            return 1;
+
+        // the kernels may round differently, use the one of the baseline
+        std::string kernel = getString(header, "kernel");
+        for (int k = 0; k < (int)QuadricKernel::Count; ++k)
+        {
+            if (kernel == getKernelName((QuadricKernel)k) && !setQuadricKernel((QuadricKernel)k))
+                printf("The baseline kernel \"%s\" is not supported by this cpu, the results may differ.\n", kernel.c_str());
+        }
+    }
+
+    printf("Quadric kernel: %s, %zd threads, %zd runs per mesh\n", getKernelName(getQuadricKernel()), options.threads, options.repeats);
+    std::vector<CaseResult> results = runWorkload(options);
+
+    if (options.update)
+    {
+        if (!writeBaseline(options.baseline, results, options))
+            return 1;
+
+        printf("Wrote the baseline \"%s\" with %zd meshes.\n", options.baseline.c_str(), results.size());
+        return 0;
+    }
+
+    bool passed = checkResults(results, header, cases, options);
+    printf(passed ? "Performance check passed.\n" : "Performance check FAILED.\n");
+    return passed ? 0 : 1;
+}
@@ -1,3 +1,9 @@
+newoption
+{
+    trigger = "instrument",
+    description = "Collect simplifier statistics and trace events in release builds"
+}
+
 workspace "MeshSimplifier"
     architecture "x64"
     startproject "MeshSimplifier"
@@ -14,16 +20,21 @@ workspace "MeshSimplifier"
     filter "configurations:Debug"
         runtime "Debug"
         symbols "On"
+        defines { "MS_INSTRUMENT" }
         
     filter "configurations:OptimizedDebug"
         runtime "Debug"
         symbols "On"
         optimize "On"
+        defines { "MS_INSTRUMENT" }
 
     filter "configurations:Release"
         runtime "Release"
         optimize "On"
 
+    filter "options:instrument"
+        defines { "MS_INSTRUMENT" }
+
 output_dir = "%{cfg.buildcfg}"
 
 group "Packages"
@@ -34,9 +45,68 @@ include "packages/imgui.lua"
 
 group ""
 
+project "Simplifier"
+    kind "StaticLib"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+    objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+    files
+    {
+        "core/**.hpp",
+        "core/**.cpp"
+    }
+
+    includedirs
+    {
+        "core",
+        "packages/glm/"
+    }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+
+project "meshsimplify"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+    objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+    files
+    {
+        "cli/**.hpp",
+        "cli/**.cpp"
+    }
+
+    links
+    {
+        "Simplifier"
+    }
+
+    includedirs
+    {
+        "core",
+        "packages/glm/"
+    }
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+
 project "MeshSimplifier"
     kind "ConsoleApp"
     language "C++"
+    cppdialect "C++20"
     staticruntime "On"
     
     targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
@@ -55,6 +125,7 @@ project "MeshSimplifier"
 
     links
     {
+        "Simplifier",
         "GLFW",
         "Ignis",
         "ImGui",
@@ -64,6 +135,7 @@ project "MeshSimplifier"
     includedirs
     {
         "src",
+        "core",
         "packages/glfw/include",
         "packages/Ignis/src",
         "packages/glm/",
@@ -77,3 +149,75 @@ project "MeshSimplifier"
     filter "system:windows"
         systemversion "latest"
         defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+
+project "Benchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+    objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+    files
+    {
+        "bench/**.hpp",
+        "bench/**.cpp"
+    }
+
+    links
+    {
+        "Simplifier"
+    }
+
+    includedirs
+    {
+        "bench",
+        "core",
+        "packages/glm/"
+    }
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+        links { "psapi" }
+
+-- compares timings and results against perf/baseline.json, run from the repository root
+project "PerfCheck"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+    objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+    files
+    {
+        "perf/**.cpp",
+        "bench/Generators.cpp",
+        "bench/Memory.cpp"
+    }
+
+    links
+    {
+        "Simplifier"
+    }
+
+    includedirs
+    {
+        "bench",
+        "core",
+        "packages/glm/"
+    }
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+        links { "psapi" }
@@ -78,6 +78,9 @@ void GLFWApplication::run()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        frameTimes[frameIndex] = deltaTime * 1000.0f;
+        frameIndex = (frameIndex + 1) % FRAME_HISTORY;
+
         onUpdate(deltaTime);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -12,6 +12,11 @@ protected:
     // timing
     float deltaTime;
     float lastFrame;
+
+    // frame times of the last frames in milliseconds (ring buffer, frameIndex is the oldest entry)
+    static const int FRAME_HISTORY = 120;
+    float frameTimes[FRAME_HISTORY] = { };
+    int frameIndex = 0;
 public:
     GLFWApplication(const char* title, int width, int height, bool debug);
     ~GLFWApplication();
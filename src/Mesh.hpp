@@ -1,21 +1,10 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <span>
 
 #include <Ignis/Ignis.h>
 #include <glm/glm.hpp>
 
-// struct to load an .obj file into two vectors
-struct MeshData
-{
-    std::vector<glm::vec3> vertices;
-    std::vector<uint32_t> indices;
-
-    MeshData(const std::string& filename);
-    ~MeshData();
-};
-
 // class for creating an vertex array for a mesh and rendering it
 class Mesh
 {
@@ -23,11 +12,11 @@ private:
     IgnisVertexArray vao;
 
 public:
-    Mesh(std::vector<glm::vec3> vertices, std::vector<uint32_t> indices);
+    Mesh(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices);
     ~Mesh();
 
-    // write new data into the buffers (can resize them)
-    void recreate(std::vector<glm::vec3> vertices, std::vector<uint32_t> indices);
+    // write new data into the buffers (can resize them), the data is uploaded directly
+    void recreate(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices);
 
     // render the mesh
     void render();
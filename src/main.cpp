@@ -1,7 +1,11 @@
 #include "App.hpp"
 
 #include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "MeshOptimizer.hpp"
 #include "MeshSimplifier.hpp"
+#include "ObjWriter.hpp"
+#include "SimplifierWorker.hpp"
 
 #include "Camera.hpp"
 
@@ -24,26 +28,37 @@ float lastY = SCR_HEIGHT / 2.0f;
 // mesh
 const char* models[] = { "Marsienne_Base", "monkey", "cube" };
 std::string getModelPath(int i) { return "res/" + std::string(models[i]) + ".obj"; }
+std::string getExportPath(int i, const char* extension) { return "res/" + std::string(models[i]) + ".simplified" + extension; }
 
 int currentModel = 1;
-MeshData data(getModelPath(currentModel));
 
 class Application : public GLFWApplication
 {
 private:
     IgnisShader shader;
 
+    MeshData data;
     Mesh mesh;
     MeshSimplifier simplifier;
+    SimplifierWorker worker;
+    ProgressiveMesh progressive;
+    ProgressiveMesh builtProgressive;   // written by the worker, moved to progressive once it finished
+    bool buildingProgressive = false;
 
     bool showWireframe = false;
     bool cullBackFaces = false;
     int targetFaces = 0;
+    bool parallelCollapse = false;
+    bool clusterFirst = false;
+    int lodFaces = 0;
+    bool overdrawOrder = false;
+    MeshOptimizeReport optimizeReport;
 public:
     Application() :
         GLFWApplication("Mesh Simplifier", SCR_WIDTH, SCR_HEIGHT, true), 
-        simplifier(data.vertices, data.indices), 
-        mesh(data.vertices, data.indices)
+        data(getModelPath(currentModel)),
+        simplifier(data.getVertices(), data.getIndices()), 
+        mesh(data.getVertices(), data.getIndices())
     {
         ignisCreateShadervf(&shader, "res/shaders/shader.vert", "res/shaders/shader.frag");
 
@@ -59,6 +74,82 @@ public:
     {
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
+
+        // show the mesh shrink while the worker runs
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indices;
+        if (worker.takeSnapshot(vertices, indices))
+            mesh.recreate(vertices, indices);
+
+        if (worker.poll())
+        {
+            worker.takeSnapshot(vertices, indices);
+            mesh.recreate(simplifier.getVertices(), simplifier.getIndices());
+            targetFaces = simplifier.getFaceCount();
+
+            if (buildingProgressive)
+                finishProgressive();
+            else
+                printf("Mesh simplified (%zd faces in %.2fs%s).\n", simplifier.getFaceCount(), worker.getSeconds(), worker.wasCancelled() ? ", cancelled" : "");
+        }
+    }
+
+    // simplify on the worker thread, the render loop keeps running
+    void startSimplify()
+    {
+        bool cluster = clusterFirst;
+        bool parallel = parallelCollapse;
+        size_t target = targetFaces;
+
+        worker.start(simplifier, target, [cluster, parallel, target](MeshSimplifier& s)
+            {
+                if (cluster)
+                    s.runClustered(target);
+                else if (parallel)
+                    s.runParallel(target);
+                else
+                    s.run(target);
+            });
+    }
+
+    // record the whole collapse sequence on the worker, the simplifier is reset to the loaded mesh afterwards
+    void startProgressive()
+    {
+        std::span<const glm::vec3> vertices = data.getVertices();
+        std::span<const uint32_t> indices = data.getIndices();
+
+        targetFaces = 0;
+        buildingProgressive = true;
+
+        // the setup runs on the worker as well, it takes seconds on large meshes
+        worker.start(simplifier, 0, [this, vertices, indices](MeshSimplifier& s)
+            {
+                s.setRecording(true);
+                s.setup(vertices, indices);
+                s.run(0);
+                s.setRecording(false);
+
+                // a cancelled sequence is incomplete and dropped
+                if (!worker.wasCancelled())
+                    builtProgressive = ProgressiveMesh(vertices, indices, s.getCollapseLog());
+
+                s.setup(vertices, indices);
+            }, indices.size() / 3);
+    }
+
+    void finishProgressive()
+    {
+        buildingProgressive = false;
+        if (worker.wasCancelled())
+        {
+            printf("Progressive mesh cancelled.\n");
+            return;
+        }
+
+        progressive = std::move(builtProgressive);
+        builtProgressive = ProgressiveMesh();
+        lodFaces = (int)progressive.getFaceCount();
+        printf("Progressive mesh built (%zd collapses in %.2fs).\n", progressive.getLevelCount(), worker.getSeconds());
     }
 
     // rendering of the mesh
@@ -99,6 +190,29 @@ public:
         mesh.render();
     }
 
+    // progress of the worker, the frame times show that the render loop keeps running
+    void renderProgress()
+    {
+        ImGui::Text("Simplifying to %d faces:", targetFaces);
+        ImGui::ProgressBar(worker.getProgress(), ImVec2(-FLT_MIN, 0.0f));
+        ImGui::Text("%zd faces left", worker.getFaceCount() > (size_t)targetFaces ? worker.getFaceCount() - targetFaces : (size_t)0);
+        ImGui::Text("%.0f collapses/s", worker.getCollapsesPerSecond());
+
+        if (ImGui::Button("Cancel", ImVec2(-FLT_MIN, 0.0f)))
+            worker.cancel();
+
+        ImGui::Separator();
+        renderFrameTimes();
+    }
+
+    // frame times of the render loop
+    void renderFrameTimes()
+    {
+        float frameTime = frameTimes[(frameIndex + FRAME_HISTORY - 1) % FRAME_HISTORY];
+        ImGui::Text("Frame: %.2f ms (%.0f fps)", frameTime, frameTime > 0.0f ? 1000.0f / frameTime : 0.0f);
+        ImGui::PlotLines("##frames", frameTimes, FRAME_HISTORY, frameIndex, NULL, 0.0f, 50.0f, ImVec2(-FLT_MIN, 40.0f));
+    }
+
     // gui rendering
     void onRenderGui()
     {
@@ -108,10 +222,20 @@ public:
         ImGui::SetNextWindowSize(ImVec2(200, camera.getHeight()));
         ImGui::Begin("Info", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
 
+        // the simplifier belongs to the worker while it runs, only its progress is shown
+        bool running = worker.isRunning();
+
         if (ImGui::CollapsingHeader("Mesh", ImGuiTreeNodeFlags_DefaultOpen))
         {
-            ImGui::Text("Vertices: %d", simplifier.getVertexCount());
-            ImGui::Text("Faces:    %d", simplifier.getFaceCount());
+            if (running)
+            {
+                ImGui::Text("Faces:    %zd", worker.getFaceCount());
+            }
+            else
+            {
+                ImGui::Text("Vertices: %zd", simplifier.getLiveVertexCount());
+                ImGui::Text("Faces:    %zd", simplifier.getFaceCount());
+            }
 
             ImGui::Separator();
 
@@ -121,12 +245,32 @@ public:
 
             ImGui::SameLine();
 
-            if (ImGui::Button("Load", ImVec2(-FLT_MIN, 0.0f)))
+            if (ImGui::Button("Load", ImVec2(-FLT_MIN, 0.0f)) && !running)
             {
                 data = MeshData(getModelPath(currentModel));
-                simplifier.setup(data.vertices, data.indices);
+                simplifier.setup(data.getVertices(), data.getIndices());
                 mesh.recreate(simplifier.getVertices(), simplifier.getIndices());
                 targetFaces = simplifier.getFaceCount();
+                progressive = ProgressiveMesh();
+            }
+
+            // write the current simplifier output next to the model
+            ImGui::Text("Export:");
+            float buttonWidth = ImGui::GetContentRegionAvail().x * 0.5f;
+            if (ImGui::Button("OBJ", ImVec2(buttonWidth, 0.0f)) && !running)
+            {
+                std::string path = getExportPath(currentModel, ".obj");
+                if (writeObj(path, simplifier.getVertices(), simplifier.getIndices()))
+                    printf("Exported \"%s\".\n", path.c_str());
+            }
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("Binary", ImVec2(-FLT_MIN, 0.0f)) && !running)
+            {
+                std::string path = getExportPath(currentModel, MESH_CACHE_EXTENSION);
+                if (writeMeshBinary(path, simplifier.getVertices(), simplifier.getIndices()))
+                    printf("Exported \"%s\".\n", path.c_str());
             }
 
             ImGui::Dummy(ImVec2(0.0f, 16.0f));
@@ -134,27 +278,108 @@ public:
 
         if (ImGui::CollapsingHeader("Simplifier", ImGuiTreeNodeFlags_DefaultOpen))
         {
-            ImGui::Text("Target Faces:");
-            ImGui::SetNextItemWidth(-FLT_MIN);
-            ImGui::SliderInt("##faces", &targetFaces, 0, simplifier.getFaceCount());
-
-            float buttonWidth = ImGui::GetContentRegionAvail().x * 0.5f;
-            if (ImGui::Button("Simplify", ImVec2(buttonWidth, 0.0f)))
+            if (running)
             {
-                simplifier.run(targetFaces);
-                mesh.recreate(simplifier.getVertices(), simplifier.getIndices());
-                targetFaces = simplifier.getFaceCount();
-                printf("Mesh simplified (%zd faces).\n", simplifier.getFaceCount());
+                renderProgress();
             }
-
-            ImGui::SameLine();
-
-            if (ImGui::Button("Reset", ImVec2(-FLT_MIN, 0.0f)))
+            else
             {
-                simplifier.setup(data.vertices, data.indices);
-                mesh.recreate(simplifier.getVertices(), simplifier.getIndices());
-                targetFaces = simplifier.getFaceCount();
-                printf("Mesh reset.\n");
+                ImGui::Text("Target Faces:");
+                ImGui::SetNextItemWidth(-FLT_MIN);
+                ImGui::SliderInt("##faces", &targetFaces, 0, simplifier.getFaceCount());
+                ImGui::Checkbox("Parallel collapses", &parallelCollapse);
+                ImGui::Checkbox("Vertex clustering", &clusterFirst);
+
+                float buttonWidth = ImGui::GetContentRegionAvail().x * 0.5f;
+                if (ImGui::Button("Simplify", ImVec2(buttonWidth, 0.0f)))
+                    startSimplify();
+
+                ImGui::SameLine();
+
+                if (ImGui::Button("Reset", ImVec2(-FLT_MIN, 0.0f)))
+                {
+                    simplifier.setup(data.getVertices(), data.getIndices());
+                    mesh.recreate(simplifier.getVertices(), simplifier.getIndices());
+                    targetFaces = simplifier.getFaceCount();
+                    printf("Mesh reset.\n");
+                }
+
+                ImGui::Separator();
+
+                // upload a compacted and reordered copy, the simplifier keeps its state
+                ImGui::Text("Render order:");
+                ImGui::Checkbox("Overdraw", &overdrawOrder);
+                ImGui::SameLine();
+                if (ImGui::Button("Optimize", ImVec2(-FLT_MIN, 0.0f)))
+                {
+                    std::vector<glm::vec3> vertices(simplifier.getVertices().begin(), simplifier.getVertices().end());
+                    std::vector<uint32_t> indices(simplifier.getIndices().begin(), simplifier.getIndices().end());
+
+                    MeshOptimizeOptions options;
+                    options.overdraw = overdrawOrder;
+                    optimizeReport = optimizeMesh(vertices, indices, options);
+                    mesh.recreate(vertices, indices);
+                }
+
+                if (optimizeReport.verticesAfter > 0)
+                {
+                    ImGui::Text("ACMR: %.3f -> %.3f", optimizeReport.before.acmr, optimizeReport.after.acmr);
+                    ImGui::Text("ATVR: %.3f -> %.3f", optimizeReport.before.atvr, optimizeReport.after.atvr);
+                }
+
+                ImGui::Separator();
+
+                // record the whole collapse sequence once, afterwards every face count is available instantly
+                ImGui::Text("Progressive mesh:");
+                if (ImGui::Button("Build", ImVec2(-FLT_MIN, 0.0f)))
+                    startProgressive();
+
+                if (progressive.getLevelCount() > 0)
+                {
+                    ImGui::SetNextItemWidth(-FLT_MIN);
+                    if (ImGui::SliderInt("##lod", &lodFaces, (int)progressive.getMinFaceCount(), (int)progressive.getMaxFaceCount()))
+                    {
+                        progressive.setFaceCount(lodFaces);
+                        mesh.recreate(progressive.getVertices(), progressive.getIndices());
+                    }
+                }
+
+                ImGui::Separator();
+
+                renderFrameTimes();
+
+#ifdef MS_INSTRUMENT
+                if (ImGui::TreeNode("Statistics"))
+                {
+                    const SimplifierStats& stats = simplifier.getStats();
+
+                    for (size_t i = 0; i < (size_t)StatsPhase::Count; ++i)
+                        ImGui::Text("%-14s%8.2f ms", getPhaseName((StatsPhase)i), stats.time[i] * 1000.0);
+
+                    ImGui::Separator();
+                    ImGui::Text("Collapses:    %zd", stats.collapses);
+                    ImGui::Text("Recomputed:   %zd", stats.pairsRecomputed);
+                    ImGui::Text("Faces removed:%zd", stats.facesRemoved);
+
+                    ImGui::Separator();
+                    ImGui::Text("Pairs:        %zd", stats.peakPairCount);
+                    ImGui::Text("Peak heap:    %zd", stats.peakHeapSize);
+                    ImGui::Text("Max faces/v:  %zd", stats.peakVertexFaces);
+                    ImGui::Text("Max pairs/v:  %zd", stats.peakVertexPairs);
+
+                    if (traceIsActive())
+                    {
+                        if (ImGui::Button("Stop trace", ImVec2(-FLT_MIN, 0.0f)))
+                            traceEnd();
+                    }
+                    else if (ImGui::Button("Record trace", ImVec2(-FLT_MIN, 0.0f)))
+                    {
+                        traceBegin("trace.json");
+                    }
+
+                    ImGui::TreePop();
+                }
+#endif
             }
 
             ImGui::Dummy(ImVec2(0.0f, 16.0f));